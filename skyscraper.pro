@@ -5,7 +5,7 @@ INCLUDEPATH += .
 CONFIG -= debug
 CONFIG += release
 win32:CONFIG += console
-QT += core network xml sql widgets
+QT += core network xml sql widgets concurrent
 # QTPLUGIN.platforms = qoffscreen
 DEFINES *= QT_USE_QSTRINGBUILDER
 
@@ -37,6 +37,7 @@ DEFINES+=VERSION=\\\"$$VERSION\\\"
 HEADERS += src/skyscraper.h \
            src/netmanager.h \
            src/netcomm.h \
+           src/httpcache.h \
            src/xmlreader.h \
            src/settings.h \
            src/compositor.h \
@@ -106,6 +107,7 @@ SOURCES += src/main.cpp \
            src/skyscraper.cpp \
            src/netmanager.cpp \
            src/netcomm.cpp \
+           src/httpcache.cpp \
            src/xmlreader.cpp \
            src/compositor.cpp \
            src/strtools.cpp \
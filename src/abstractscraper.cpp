@@ -24,6 +24,7 @@
  */
 
 #include "abstractscraper.h"
+#include "cache.h"
 #include "platform.h"
 #include "strtools.h"
 
@@ -33,6 +34,8 @@
 #include <QFile>
 #include <QProcess>
 #include <QTemporaryFile>
+#include <QUrl>
+#include <QHostAddress>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -156,7 +159,14 @@ void AbstractScraper::getSearchResults(QList<GameEntry> &gameEntries,
 // Redirects the scraper to fetch each resource valid for the scraper.
 void AbstractScraper::fetchGameResources(GameEntry &game, QStringList &sharedBlobs, GameEntry *cache)
 {
+  bool mediaPrefetched = false;
   for(int a = 0; a < fetchOrder.length(); ++a) {
+    // The media urls usually depend on the id or title fetched before them, so the
+    // batch is only issued when reaching the first media type
+    if(!mediaPrefetched && config->concurrentMedia && isMediaType(fetchOrder.at(a))) {
+      prefetchMedia(game, fetchOrder.mid(a), sharedBlobs, cache);
+      mediaPrefetched = true;
+    }
     switch(fetchOrder.at(a)) {
     case ID:
       if((!cache) || (cache && cache->id.isEmpty())) {
@@ -224,57 +234,38 @@ void AbstractScraper::fetchGameResources(GameEntry &game, QStringList &sharedBlo
       }
       break;
     case COVER:
-      if((config->cacheCovers) &&
-         (!config->singleImagePerType || !sharedBlobs.contains("cover"))) {
-        if((!cache) || (cache && cache->coverData.isNull())) {
-          getCover(game);
-        }
+      if(wantsMedia(COVER, sharedBlobs, cache)) {
+        getCover(game);
       }
       break;
     case SCREENSHOT:
-      if((config->cacheScreenshots) &&
-         (!config->singleImagePerType || !sharedBlobs.contains("screenshot"))) {
-        if((!cache) || (cache && cache->screenshotData.isNull())) {
-          getScreenshot(game);
-        }
+      if(wantsMedia(SCREENSHOT, sharedBlobs, cache)) {
+        getScreenshot(game);
       }
       break;
     case WHEEL:
-      if((config->cacheWheels) &&
-         (!config->singleImagePerType || !sharedBlobs.contains("wheel"))) {
-        if((!cache) || (cache && cache->wheelData.isNull())) {
-          getWheel(game);
-        }
+      if(wantsMedia(WHEEL, sharedBlobs, cache)) {
+        getWheel(game);
       }
       break;
     case MARQUEE:
-      if((config->cacheMarquees) &&
-         (!config->singleImagePerType || !sharedBlobs.contains("marquee"))) {
-        if((!cache) || (cache && cache->marqueeData.isNull())) {
-          getMarquee(game);
-        }
+      if(wantsMedia(MARQUEE, sharedBlobs, cache)) {
+        getMarquee(game);
       }
       break;
     case TEXTURE:
-      if((config->cacheTextures) &&
-         (!config->singleImagePerType || !sharedBlobs.contains("texture"))) {
-        if((!cache) || (cache && cache->textureData.isNull())) {
-          getTexture(game);
-        }
+      if(wantsMedia(TEXTURE, sharedBlobs, cache)) {
+        getTexture(game);
       }
       break;
     case VIDEO:
-      if((config->videos) && (!sharedBlobs.contains("video"))) {
-        if((!cache) || (cache && cache->videoData.isEmpty())) {
-          getVideo(game);
-        }
+      if(wantsMedia(VIDEO, sharedBlobs, cache)) {
+        getVideo(game);
       }
       break;
     case MANUAL:
-      if((config->manuals) && (!sharedBlobs.contains("manual"))) {
-        if((!cache) || (cache && cache->manualData.isEmpty())) {
-          getManual(game);
-        }
+      if(wantsMedia(MANUAL, sharedBlobs, cache)) {
+        getManual(game);
       }
       break;
     case CHIPTUNE:
@@ -333,6 +324,119 @@ void AbstractScraper::fetchGameResources(GameEntry &game, QStringList &sharedBlo
       ;
     }
   }
+  if(mediaPrefetched) {
+    netComm->clearPrefetched();
+  }
+}
+
+bool AbstractScraper::isMediaType(const int type)
+{
+  return type == COVER || type == SCREENSHOT || type == WHEEL || type == MARQUEE ||
+         type == TEXTURE || type == VIDEO || type == MANUAL;
+}
+
+// Whether the media of 'type' is to be fetched for this game.
+bool AbstractScraper::wantsMedia(const int type, const QStringList &sharedBlobs, GameEntry *cache)
+{
+  QString media;
+  bool enabled = false;
+  switch(type) {
+  case COVER:
+    media = "cover";
+    enabled = config->cacheCovers;
+    break;
+  case SCREENSHOT:
+    media = "screenshot";
+    enabled = config->cacheScreenshots;
+    break;
+  case WHEEL:
+    media = "wheel";
+    enabled = config->cacheWheels;
+    break;
+  case MARQUEE:
+    media = "marquee";
+    enabled = config->cacheMarquees;
+    break;
+  case TEXTURE:
+    media = "texture";
+    enabled = config->cacheTextures;
+    break;
+  case VIDEO:
+    media = "video";
+    enabled = config->videos;
+    break;
+  case MANUAL:
+    media = "manual";
+    enabled = config->manuals;
+    break;
+  default:
+    return false;
+  }
+  if(!enabled) {
+    return false;
+  }
+  if(type == VIDEO || type == MANUAL || config->singleImagePerType) {
+    if(sharedBlobs.contains(media)) {
+      return false;
+    }
+  }
+  return !cache || !cache->hasMedia(media);
+}
+
+// Downloads the media of the game at the same time, the getters then pick the replies up
+// from netComm as if they had requested them one by one.
+void AbstractScraper::prefetchMedia(GameEntry &game, const QList<int> &types,
+                                    const QStringList &sharedBlobs, GameEntry *cache)
+{
+  QList<int> wanted;
+  for(const auto type: std::as_const(types)) {
+    // Streamed videos and manuals are downloaded by their getters
+    if(config->streamMedia && (type == VIDEO || type == MANUAL)) {
+      continue;
+    }
+    if(wantsMedia(type, sharedBlobs, cache)) {
+      wanted.append(type);
+    }
+  }
+  const QStringList urls = getMediaUrls(game, wanted);
+  if(urls.size() > 1) {
+    netComm->prefetch(urls);
+  }
+}
+
+// Downloads a video or manual. With 'streamMedia' it goes to a file in the download folder of
+// the cache instead of 'data', which the cache later moves into place. Returns its size.
+qint64 AbstractScraper::getMediaData(const QString &url, QByteArray &data, QString &file)
+{
+  discardMediaData(data, file);
+  if(config->streamMedia && !netComm->isPrefetched(url)) {
+    netComm->requestToFile(url, Cache::downloadFolder(config->cacheFolder));
+    q.exec();
+    file = netComm->getFile();
+    return (file.isEmpty()?0:QFileInfo(file).size());
+  }
+  netComm->request(url);
+  q.exec();
+  data = netComm->getData();
+  return data.size();
+}
+
+// Drops what getMediaData() got when it turns out not to be a usable video or manual
+void AbstractScraper::discardMediaData(QByteArray &data, QString &file)
+{
+  data = "";
+  if(!file.isEmpty() &&
+     QFileInfo(file).absolutePath() == Cache::downloadFolder(config->cacheFolder)) {
+    QFile::remove(file);
+    file.clear();
+  }
+}
+
+// Scrapers that know their media urls before downloading them return them here, one per
+// type in 'types' at most. The default of none keeps the media downloads one by one.
+QStringList AbstractScraper::getMediaUrls(GameEntry &, const QList<int> &)
+{
+  return QStringList();
 }
 
 // Fill in the game skeleton with the data from the scraper service.
@@ -660,11 +764,11 @@ void AbstractScraper::getVideo(GameEntry &game)
   if(videoUrl.left(4) != "http") {
     videoUrl.prepend(baseUrl + (videoUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(videoUrl);
-  q.exec();
+  getMediaData(videoUrl, game.videoData, game.videoFile);
   if(netComm->getError() == QNetworkReply::NoError) {
-    game.videoData = netComm->getData();
     game.videoFormat = videoUrl.right(3);
+  } else {
+    discardMediaData(game.videoData, game.videoFile);
   }
 }
 
@@ -685,11 +789,11 @@ void AbstractScraper::getManual(GameEntry &game)
   if(manualUrl.left(4) != "http") {
     manualUrl.prepend(baseUrl + (manualUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(manualUrl);
-  q.exec();
+  getMediaData(manualUrl, game.manualData, game.manualFile);
   if(netComm->getError() == QNetworkReply::NoError) {
-    game.manualData = netComm->getData();
     game.manualFormat = manualUrl.right(3);
+  } else {
+    discardMediaData(game.manualData, game.manualFile);
   }
 }
 
@@ -1196,6 +1300,23 @@ void AbstractScraper::addLastSearchToNegativeCache(const QString &file, const QS
   }
 }
 
+// The registrable domain of the service, so the limits also cover the media served from
+// other subdomains, like 'neoclone.screenscraper.fr' next to 'www.screenscraper.fr'. Two
+// letter country domains with a short second level, like 'co.uk', keep a third label
+QString AbstractScraper::getHost()
+{
+  const QString host = QUrl(baseUrl).host();
+  if(!QHostAddress(host).isNull()) {
+    return host;
+  }
+  const QStringList labels = host.split('.', Qt::SkipEmptyParts);
+  int keep = 2;
+  if(labels.size() > 2 && labels.last().size() == 2 && labels.at(labels.size() - 2).size() <= 3) {
+    keep = 3;
+  }
+  return labels.mid(qMax(0, labels.size() - keep)).join('.');
+}
+
 // Detects if found is a valid name for platform platform.
 bool AbstractScraper::platformMatch(QString found, QString platform) {
   const auto platforms = Platform::get().getAliases(platform);
@@ -86,6 +86,9 @@ public:
   // as the results were not successful.
   void addLastSearchToNegativeCache(const QString &file = "", const QString &lowMatch = "");
 
+  // Domain of the scraping service, empty for the scrapers reading local files
+  QString getHost();
+
   int reqRemaining = -1;
   int reqRemainingKO = -1;
 
@@ -132,6 +135,15 @@ protected:
   virtual void getTrivia(GameEntry &game);
   virtual void getChiptune(GameEntry &game);
   virtual void getCustomFlags(GameEntry &game);
+  // Urls the media getters are going to request first, so they can be downloaded at once.
+  virtual QStringList getMediaUrls(GameEntry &game, const QList<int> &types);
+
+  bool isMediaType(const int type);
+  bool wantsMedia(const int type, const QStringList &sharedBlobs, GameEntry *cache);
+  void prefetchMedia(GameEntry &game, const QList<int> &types,
+                     const QStringList &sharedBlobs, GameEntry *cache);
+  qint64 getMediaData(const QString &url, QByteArray &data, QString &file);
+  void discardMediaData(QByteArray &data, QString &file);
 
   // Consume text in data until finding nom.
   virtual void nomNom(const QString nom, bool including = true);
@@ -230,43 +230,39 @@ void ArcadeDB::getVideo(GameEntry &game)
      jsonObj.value("url_video_shortplay").toString().isEmpty()) {
     return;
   }
-  netComm->request(jsonObj.value("url_video_shortplay").toString());
-  q.exec();
-  game.videoData = netComm->getData();
+  qint64 videoSize = getMediaData(jsonObj.value("url_video_shortplay").toString(),
+                                  game.videoData, game.videoFile);
   if(netComm->getError() == QNetworkReply::NoError &&
-     game.videoData.length() > 4096) {
+     videoSize > 4096) {
     game.videoFormat = "mp4";
   } else {
-    netComm->request("https://www.progettosnaps.net/videosnaps/mp4/" + game.id + ".mp4");
-    q.exec();
-    game.videoData = netComm->getData();
+    videoSize = getMediaData("https://www.progettosnaps.net/videosnaps/mp4/" + game.id + ".mp4",
+                             game.videoData, game.videoFile);
     if(netComm->getError() == QNetworkReply::NoError &&
-       game.videoData.length() > 4096) {
+       videoSize > 4096) {
       game.videoFormat = "mp4";
     } else {    
-      game.videoData = "";
+      discardMediaData(game.videoData, game.videoFile);
     }
   }
 }
 
 void ArcadeDB::getManual(GameEntry &game)
 {
-  netComm->request("http://adb.arcadeitalia.net/download_file.php?tipo=mame_current&codice=" +
-         game.id + "&entity=manual&oper=view&filler=" + game.id + ".pdf");
-  q.exec();
-  game.manualData = netComm->getData();
+  qint64 manualSize = getMediaData("http://adb.arcadeitalia.net/download_file.php?tipo=mame_current&codice=" +
+                                   game.id + "&entity=manual&oper=view&filler=" + game.id + ".pdf",
+                                   game.manualData, game.manualFile);
   if(netComm->getError() == QNetworkReply::NoError &&
-     game.manualData.length() > 4096) {
+     manualSize > 4096) {
     game.manualFormat = "pdf";
   } else {
-    netComm->request("https://www.progettosnaps.net/manuals/pdf/" + game.id + ".pdf");
-    q.exec();
-    game.manualData = netComm->getData();
+    manualSize = getMediaData("https://www.progettosnaps.net/manuals/pdf/" + game.id + ".pdf",
+                              game.manualData, game.manualFile);
     if(netComm->getError() == QNetworkReply::NoError &&
-       game.manualData.length() > 4096) {
+       manualSize > 4096) {
       game.manualFormat = "pdf";
     } else {    
-      game.manualData = "";
+      discardMediaData(game.manualData, game.manualFile);
     }
   }
 }
@@ -24,6 +24,11 @@
  */
 
 #include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <QBuffer>
 #include <QProcess>
@@ -38,6 +43,17 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QVector>
+#include <QtEndian>
+#include <QThread>
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QSaveFile>
+#include <QCryptographicHash>
 
 #include "cache.h"
 #include "strtools.h"
@@ -45,6 +61,47 @@
 #include "queue.h"
 #include "nametools.h"
 
+// Journal records are length prefixed so a record torn by a crash can be dropped on replay
+constexpr quint32 JOURNALMAGIC = 0x534b594a; // "SKYJ"
+constexpr quint32 JOURNALVERSION = 1;
+constexpr quint8 JOURNALADD = 1;
+constexpr quint8 JOURNALREMOVE = 2;
+constexpr quint8 JOURNALQUICKID = 3;
+constexpr quint8 JOURNALFILEKEY = 4;
+
+// Binary db.bin layout (little endian): magic, version, string table, resources
+constexpr quint32 BINMAGIC = 0x534b5942; // "SKYB"
+constexpr quint32 BINVERSION = 2; // 2: long texts may be stored compressed
+constexpr quint32 BINPACKED = 0x80000000; // Set on the length of a compressed value
+
+// Texts shorter than this many characters aren't worth compressing
+constexpr int PACKMIN = 256;
+
+// db.xml files smaller than two of these are parsed on a single thread
+constexpr int XMLCHUNKMIN = 1024 * 1024;
+
+// Resources handed to merge() at a time when streaming from the other cache
+constexpr int MERGEBATCH = 4096;
+
+// Media files are removed by at most this many threads, more only contend for the disk
+constexpr int IOTHREADSMAX = 8;
+
+// One past the highest resource type id in gameentry.h
+constexpr int TYPECOUNT = CANONICALCATALOG + 1;
+
+// media.manifest layout: magic, version, then per folder its path, mtime, subfolders and files
+constexpr quint32 MANIFESTMAGIC = 0x534b594d; // "SKYM"
+constexpr quint32 MANIFESTVERSION = 1;
+
+// shards/<source>.xml|bin.idx layout: magic, version, then the resource types of every rom as a
+// bitmask of their type ids
+constexpr quint32 SHARDINDEXMAGIC = 0x534b5949; // "SKYI"
+constexpr quint32 SHARDINDEXVERSION = 1;
+
+// checksums.cache layout: magic, version, then the rom checksums by path, size and mtime
+constexpr quint32 CHECKSUMSMAGIC = 0x534b5943; // "SKYC"
+constexpr quint32 CHECKSUMSVERSION = 1;
+
 Cache::Cache(const QString &cacheFolder, const QString &scraper)
 {
   cacheDir = QDir(cacheFolder);
@@ -56,6 +113,12 @@ Cache::Cache(const QString &cacheFolder, const QString &scraper)
   }
 }
 
+Cache::~Cache()
+{
+  flushJournal();
+  closeDatabase();
+}
+
 void Cache::loadCanonicalMap(const QString &json, QMap<QString, QString> *canonicalMap)
 {
   canonicalMap->clear();
@@ -105,6 +168,12 @@ bool Cache::createFolders()
     if(!cacheDir.mkpath(cacheDir.absolutePath() + "/manuals/" + globalScraper)) {
       return false;
     }
+    // Anything left in here is from a run that was interrupted
+    QDir downloads(downloadFolder(cacheDir.absolutePath()));
+    downloads.removeRecursively();
+    if(!cacheDir.mkpath(downloads.absolutePath())) {
+      return false;
+    }
   }
 
   // Copy priorities.xml example file to cache folder if it doesn't already exist
@@ -116,11 +185,167 @@ bool Cache::createFolders()
   return true;
 }
 
+// Videos and manuals are streamed into this folder by NetComm before they are moved into the cache
+QString Cache::downloadFolder(const QString &cacheFolder)
+{
+  return QDir(cacheFolder).absolutePath() + "/downloads";
+}
+
+bool Cache::isDownload(const QString &fileName)
+{
+  return !fileName.isEmpty() &&
+    QFileInfo(fileName).absolutePath() == downloadFolder(cacheDir.absolutePath());
+}
+
+// Moves a file streamed by NetComm into place. Its name starts with the sha1 of its content,
+// which is returned in 'digest'.
+bool Cache::moveDownload(const QString &fileName, const QString &cacheFile, QString &digest)
+{
+  QFile::remove(cacheFile);
+  if(!QFile::rename(fileName, cacheFile)) {
+    // The cache may have its media folders on another file system
+    if(!QFile::copy(fileName, cacheFile)) {
+      return false;
+    }
+    QFile::remove(fileName);
+  }
+  digest = QFileInfo(fileName).fileName().section('-', 0, 0);
+  return true;
+}
+
+// Prefer the configured format, but load whichever exists so switching formats never loses data
+QString Cache::existingFormat()
+{
+  QString format = Skyscraper::config.cacheFormat;
+  if(!hasCacheFile(format)) {
+    const QStringList formats = {"xml", "binary", "sqlite"};
+    for(const auto &existingFormat: formats) {
+      if(hasCacheFile(existingFormat)) {
+        format = existingFormat;
+        break;
+      }
+    }
+  }
+  return format;
+}
+
 bool Cache::read()
+{
+  QString format = existingFormat();
+  sqliteBacked = (format == "sqlite");
+  // Scraping and game list runs only ever look up single roms, so there is no need to load
+  // the whole database up front. The same goes for merging into it. Everything else works
+  // on the full cache in memory.
+  const QString &options = Skyscraper::config.cacheOptions;
+  lazyLoad = sqliteBacked && Skyscraper::config.cacheFormat == "sqlite" &&
+             (options.isEmpty() || options == "refresh" || options == "rescan" ||
+              options == "ignorenegativecache" || options.startsWith("merge:"));
+
+  QMap<QString, bool> idHash = readQuickIds();
+
+  bool loaded = false;
+  QFile cacheFile(cacheFileName(format));
+  if(lazyLoad) {
+    loaded = readSqliteSummary();
+  } else if(!cacheFile.exists() && !shardSources(format).isEmpty()) {
+    loaded = readShards(format, idHash);
+  } else if(cacheFile.open(QIODevice::ReadOnly)) {
+    printf("Building file lookup cache, please wait... "); fflush(stdout);
+    QSet<QString> fileEntries = scanMedia();
+    printf("\033[1;32mDone!\033[0m\n");
+    printf("Cached %d files\n\n", fileEntries.count());
+
+    printf("Reading and parsing resource cache, please wait... "); fflush(stdout);
+    bool parsed = false;
+    auto insert = [this](Resource &resource) {
+      addToResCounts(resource.source, resource.type);
+      insertResource(resource);
+    };
+    if(format == "binary") {
+      parsed = readBinary(cacheFile, fileEntries, idHash, insert);
+    } else if(format == "sqlite") {
+      parsed = readSqlite(fileEntries, idHash, insert);
+    } else {
+      parsed = readXml(cacheFile, fileEntries, idHash);
+    }
+    cacheFile.close();
+    resAtLoad = resourceCount();
+    if(parsed) {
+      printf("\033[1;32mDone!\033[0m\n");
+    } else {
+      printf("\033[1;31mFailed!\033[0m\n'%s' is damaged, only the resources read before the error were loaded.\n",
+             cacheFile.fileName().toStdString().c_str());
+    }
+    printf("Successfully parsed %d resources for %d roms!\n\n", resAtLoad, resources.size());
+    loaded = true;
+  }
+
+  // Changes from a previous run that never got to write db.xml (crash, ctrl+c, ...)
+  if(replayJournal(idHash) > 0) {
+    loaded = true;
+  }
+  return loaded;
+}
+
+// Loads only the resources of the given roms. Runs on a handful of roms would otherwise
+// spend most of their time parsing and holding resources they never look at
+bool Cache::readSubset(const QList<QFileInfo> &files)
+{
+  // The database is loaded lazily anyway, and a cache that is converted to another
+  // format on write has to be loaded in full
+  if(existingFormat() == "sqlite" || existingFormat() != Skyscraper::config.cacheFormat) {
+    return read();
+  }
+  subsetLoad = true;
+  for(const auto &info: files) {
+    subsetFiles.insert(info.absoluteFilePath());
+  }
+  bool loaded = read();
+  // write() leaves the cache files alone, so everything has to go through the journal.
+  // Game list runs never add resources. The quick ids they hash are simply hashed again
+  // next time, which is cheaper than appending to the journal on every run
+  if(globalScraper != "cache") {
+    startJournal();
+  }
+  return loaded;
+}
+
+// Device, inode and size of a file. These stay the same when the file is renamed or
+// moved within the same file system
+static QString fileKey(const QString &filePath)
+{
+  struct stat fileStat;
+  if(::stat(QFile::encodeName(filePath).constData(), &fileStat) != 0) {
+    return QString();
+  }
+  return QString::number(fileStat.st_dev) + ":" + QString::number(fileStat.st_ino) + ":" +
+    QString::number(fileStat.st_size);
+}
+
+// Reads the quick ids and returns the cache ids they reference
+QMap<QString, bool> Cache::readQuickIds()
 {
   QFile quickIdFile(cacheDir.absolutePath() + "/quickid.xml");
   QMap<QString, bool> idHash;
-  if(quickIdFile.open(QIODevice::ReadOnly)) {
+  if(sqliteBacked) {
+    printf("Reading quick ids from cache database, please wait... "); fflush(stdout);
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    if(query.exec("SELECT filepath, timestamp, cacheid, filekey FROM quickids")) {
+      while(query.next()) {
+        QPair<qint64, QString> pair;
+        pair.first = query.value(1).toLongLong();
+        pair.second = query.value(2).toString();
+        idHash[pair.second] = true;
+        quickIds[query.value(0).toString()] = pair;
+        addFileKey(query.value(0).toString(), query.value(3).toString());
+      }
+      printf("\033[1;32mDone!\033[0m\n");
+    } else {
+      printf("\033[1;31mFailed!\033[0m\n");
+      qDebug() << query.lastError();
+    }
+  } else if(quickIdFile.open(QIODevice::ReadOnly)) {
     printf("Reading and parsing quick id xml, please wait... "); fflush(stdout);
     QXmlStreamReader xml(&quickIdFile);
     while(!xml.atEnd()) {
@@ -140,82 +365,592 @@ bool Cache::read()
       QPair<qint64, QString> pair;
       pair.first = attribs.value("timestamp").toULongLong();
       pair.second = attribs.value("id").toString();
+      if(subsetLoad && !subsetFiles.contains(attribs.value("filepath").toString())) {
+        // Still needed to recognize queued roms that were renamed or moved
+        if(attribs.hasAttribute("filekey")) {
+          fileKeyIds[attribs.value("filekey") + ":" + QString::number(pair.first)] = pair.second;
+        }
+        continue;
+      }
       idHash[pair.second] = true;
       quickIds[attribs.value("filepath").toString()] = pair;
+      addFileKey(attribs.value("filepath").toString(), attribs.value("filekey").toString());
     }
     printf("\033[1;32mDone!\033[0m\n");
   }
+  return idHash;
+}
 
-  QFile cacheFile(cacheDir.absolutePath() + "/db.xml");
-  if(cacheFile.open(QIODevice::ReadOnly)) {
-    printf("Building file lookup cache, please wait... "); fflush(stdout);
+bool Cache::hasCacheFile(const QString &format)
+{
+  return QFileInfo::exists(cacheFileName(format)) || !shardSources(format).isEmpty();
+}
 
-    QSet<QString> fileEntries;
-    QStringList binTypes;
-    binTypes << "cover" << "screenshot" << "wheel" << "marquee" << "texture" << "video" << "manual";
-    for(auto const &t: binTypes) {
-      QDir dir(cacheDir.absolutePath() + "/" + t + "s", "*.*", QDir::Name,
-               QDir::Files);
-      QDirIterator it(dir.absolutePath(),
-                      QDir::Files | QDir::NoDotAndDotDot,
-                      QDirIterator::Subdirectories);
-      while(it.hasNext()) {
-        fileEntries.insert(it.next());
+// Sources that have a shard of the given format in the 'shards' folder
+QStringList Cache::shardSources(const QString &format)
+{
+  QStringList sources;
+  if(format == "sqlite") {
+    return sources;
+  }
+  QDir shardsDir(cacheDir.absolutePath() + "/shards", QString("*.") + (format == "binary"?"bin":"xml"),
+                 QDir::Name, QDir::Files);
+  const auto shardInfos = shardsDir.entryInfoList();
+  for(const auto &shardInfo: shardInfos) {
+    sources.append(shardInfo.completeBaseName());
+  }
+  return sources;
+}
+
+QString Cache::shardFileName(const QString &format, const QString &source)
+{
+  return cacheDir.absolutePath() + "/shards/" + source + (format == "binary"?".bin":".xml");
+}
+
+// Reads the per source shards of the cache. Scraping runs only look at the resources of their
+// own source and 'generic' in detail. For the other sources, which resource types each rom
+// has is all they need, and that is read from the small index written next to every shard
+bool Cache::readShards(const QString &format, const QMap<QString, bool> &idHash)
+{
+  const QString &options = Skyscraper::config.cacheOptions;
+  // Changes in a leftover journal may belong to any source, so those need everything loaded
+  const bool journalEmpty = QFileInfo(cacheDir.absolutePath() + "/db.journal").size() <=
+    (qint64)(sizeof(JOURNALMAGIC) + sizeof(JOURNALVERSION));
+  const bool partial = !subsetLoad && globalScraper != "cache" && journalEmpty &&
+                       (options.isEmpty() || options == "refresh" || options == "rescan" ||
+                        options == "ignorenegativecache");
+
+  printf("Building file lookup cache, please wait... "); fflush(stdout);
+  QSet<QString> fileEntries = scanMedia();
+  printf("\033[1;32mDone!\033[0m\n");
+  printf("Cached %d files\n\n", fileEntries.count());
+
+  printf("Reading and parsing resource cache shards, please wait... "); fflush(stdout);
+  auto insert = [this](Resource &resource) {
+    addToResCounts(resource.source, resource.type);
+    insertResource(resource);
+  };
+  // Every source this run can add resources to is loaded in full, or writeShards() would
+  // replace its shard with only the new resources. The docsdb module stores its resources
+  // under the document type that is scraped
+  QSet<QString> writable = { globalScraper, "generic" };
+  if(globalScraper == "docsdb") {
+    for(const auto &docType: std::as_const(Skyscraper::config.docTypes)) {
+      writable.insert(docType);
+    }
+  }
+  QStringList damaged;
+  const QStringList sources = shardSources(format);
+  for(const auto &source: sources) {
+    if(partial && !writable.contains(source) && readShardIndex(format, source)) {
+      continue;
+    }
+    QFile shardFile(shardFileName(format, source));
+    bool parsed = false;
+    if(shardFile.open(QIODevice::ReadOnly)) {
+      if(format == "binary") {
+        parsed = readBinary(shardFile, fileEntries, idHash, insert);
+      } else {
+        parsed = readXml(shardFile, fileEntries, idHash);
       }
+      shardFile.close();
     }
+    if(!parsed) {
+      damaged.append(shardFile.fileName());
+    }
+    loadedShards.insert(source);
+  }
+  partialShards = loadedShards.size() < sources.size();
+  resAtLoad = resourceCount();
+  if(damaged.isEmpty()) {
     printf("\033[1;32mDone!\033[0m\n");
-    printf("Cached %d files\n\n", fileEntries.count());
+  } else {
+    printf("\033[1;31mFailed!\033[0m\n");
+    for(const auto &shardFile: std::as_const(damaged)) {
+      printf("'%s' is damaged, only the resources read before the error were loaded.\n",
+             shardFile.toStdString().c_str());
+    }
+  }
+  printf("Successfully parsed %d resources for %d roms from %d of %d shards!\n\n",
+         resAtLoad, resources.size(), loadedShards.size(), sources.size());
+  return true;
+}
 
-    printf("Reading and parsing resource cache, please wait... "); fflush(stdout);
-    QXmlStreamReader xml(&cacheFile);
-    while(!xml.atEnd()) {
-      if(xml.readNext() != QXmlStreamReader::StartElement) {
-        continue;
+// Adds the resource types per rom of a shard that isn't loaded to 'shardTypes'
+bool Cache::readShardIndex(const QString &format, const QString &source)
+{
+  QFile indexFile(shardFileName(format, source) + ".idx");
+  if(!indexFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&indexFile);
+  quint32 magic = 0;
+  quint32 version = 0;
+  QHash<QString, quint64> types;
+  in >> magic >> version;
+  if(magic != SHARDINDEXMAGIC || version != SHARDINDEXVERSION) {
+    return false;
+  }
+  in >> types;
+  // An index older than its shard may miss resources, so the shard is loaded instead
+  if(in.status() != QDataStream::Ok ||
+     QFileInfo(indexFile).lastModified() < QFileInfo(shardFileName(format, source)).lastModified()) {
+    return false;
+  }
+  for(auto it = types.cbegin(); it != types.cend(); ++it) {
+    shardTypes[it.key()] |= it.value();
+  }
+  return true;
+}
+
+bool Cache::writeShards(const QString &format)
+{
+  if(!cacheDir.mkpath(cacheDir.absolutePath() + "/shards")) {
+    return false;
+  }
+  QStringList cacheIds = resources.keys();
+  cacheIds.sort();
+  QSet<int> sources;
+  for(const auto &bucket: std::as_const(resources)) {
+    for(const auto &resource: bucket.resources) {
+      sources.insert(resource.sourceId);
+    }
+  }
+  bool binary = format == "binary";
+  for(const auto source: std::as_const(sources)) {
+    const QString shardFileOrig = shardFileName(format, sourceNames.at(source));
+    if(partialShards && !loadedShards.contains(sourceNames.at(source)) &&
+       QFileInfo::exists(shardFileOrig)) {
+      // Only what this run added is in memory, writing it would drop the rest of the shard
+      printf("\033[1;31mShard '%s' wasn't loaded, leaving it untouched.\033[0m\n",
+             shardFileOrig.toStdString().c_str());
+      continue;
+    }
+    QFile shardFile(shardFileOrig + ".tmp");
+    if(!shardFile.open(QIODevice::WriteOnly)) {
+      return false;
+    }
+    bool result = binary?writeBinary(shardFile, cacheIds, source):writeXml(shardFile, cacheIds, source);
+    shardFile.close();
+    if(!result) {
+      shardFile.remove();
+      return false;
+    }
+    QFile::remove(shardFileOrig);
+    QFile::rename(shardFileOrig + ".tmp", shardFileOrig);
+    // Written after the shard, an index older than its shard is considered stale
+    QHash<QString, quint64> types;
+    for(auto it = resources.cbegin(); it != resources.cend(); ++it) {
+      for(const auto &resource: it.value().resources) {
+        if(resource.sourceId == source && resource.typeId >= 0) {
+          types[it.key()] |= Q_UINT64_C(1) << resource.typeId;
+        }
       }
-      if(xml.name() != "resource") {
-        continue;
+    }
+    QFile indexFile(shardFileOrig + ".idx");
+    if(indexFile.open(QIODevice::WriteOnly)) {
+      QDataStream out(&indexFile);
+      out << SHARDINDEXMAGIC << SHARDINDEXVERSION << types;
+      indexFile.close();
+    }
+  }
+  // Shards that were loaded but have no resources left are removed. Shards that weren't
+  // loaded are none of this run's business
+  const QStringList existingSources = shardSources(format);
+  for(const auto &source: existingSources) {
+    if(sources.contains(sourceId(source)) || (partialShards && !loadedShards.contains(source))) {
+      continue;
+    }
+    QFile::remove(shardFileName(format, source));
+    QFile::remove(shardFileName(format, source) + ".idx");
+  }
+  return true;
+}
+
+// Result of parsing one range of <resource> elements from db.xml
+struct XmlChunk
+{
+  QList<Resource> resources;
+  QHash<QPair<QString, QString>, int> resCounts;
+  QStringList messages;
+  bool error = false;
+};
+
+// Reads a range of the mapped db.xml, wrapped in its own root element where the range
+// doesn't hold the document's, so the range parses without being copied out first
+class XmlRange : public QIODevice
+{
+public:
+  XmlRange(const char *data, qint64 size, bool openRoot, bool closeRoot)
+  {
+    if(openRoot) {
+      parts.append(QByteArray::fromRawData("<resources>", 11));
+    }
+    parts.append(QByteArray::fromRawData(data, size));
+    if(closeRoot) {
+      parts.append(QByteArray::fromRawData("</resources>", 12));
+    }
+    open(QIODevice::ReadOnly);
+  }
+  bool isSequential() const override
+  {
+    return true;
+  }
+
+protected:
+  qint64 readData(char *out, qint64 maxSize) override
+  {
+    qint64 read = 0;
+    while(read < maxSize && part < parts.size()) {
+      const QByteArray &current = parts.at(part);
+      const qint64 length = qMin(maxSize - read, qint64(current.size()) - offset);
+      memcpy(out + read, current.constData() + offset, length);
+      read += length;
+      offset += length;
+      if(offset == current.size()) {
+        ++part;
+        offset = 0;
       }
-      QXmlStreamAttributes attribs = xml.attributes();
-      if(!attribs.hasAttribute("sha1") && !attribs.hasAttribute("id")) {
-        printf("Resource is missing unique id, skipping...\n");
-        continue;
+    }
+    return read == 0 && part == parts.size()?-1:read;
+  }
+  qint64 writeData(const char *, qint64) override
+  {
+    return -1;
+  }
+
+private:
+  QList<QByteArray> parts;
+  int part = 0;
+  qint64 offset = 0;
+};
+
+static XmlChunk parseXmlChunk(const char *data, qint64 size, bool openRoot, bool closeRoot,
+                              const QString &cachePath, const QSet<QString> &fileEntries,
+                              const QMap<QString, bool> &idHash)
+{
+  XmlChunk chunk;
+  // The same few types and sources are repeated on every resource and the resources
+  // of a rom are written next to each other, so reuse the strings rather than
+  // allocating new ones for each element
+  QVector<QString> types;
+  QVector<QString> sources;
+  QString cacheId;
+  auto intern = [](QVector<QString> &strings, QStringView value) {
+    for(const auto &string: std::as_const(strings)) {
+      if(string == value) {
+        return string;
       }
+    }
+    strings.append(value.toString());
+    return strings.last();
+  };
 
-      Resource resource;
-      if(attribs.hasAttribute("sha1")) { // Obsolete, but needed for backwards compat
-        resource.cacheId = attribs.value("sha1").toString();
-      } else {
-        if(idHash.contains(attribs.value("id").toString())) {
-          resource.cacheId = attribs.value("id").toString();
-        }
-        else {
-          printf("Resource with cache id '%s' has no reference in the quickid file, skipping...\n",
-                 attribs.value("id").toString().toStdString().c_str());
+  XmlRange range(data, size, openRoot, closeRoot);
+  QXmlStreamReader xml(&range);
+  while(!xml.atEnd()) {
+    if(xml.readNext() != QXmlStreamReader::StartElement) {
+      continue;
+    }
+    if(xml.name() != QLatin1String("resource")) {
+      continue;
+    }
+    QXmlStreamAttributes attribs = xml.attributes();
+    if(!attribs.hasAttribute("sha1") && !attribs.hasAttribute("id")) {
+      chunk.messages.append("Resource is missing unique id, skipping...\n");
+      continue;
+    }
+
+    Resource resource;
+    if(attribs.hasAttribute("sha1")) { // Obsolete, but needed for backwards compat
+      resource.cacheId = attribs.value("sha1").toString();
+    } else {
+      const QStringView id = attribs.value("id");
+      if(cacheId.isNull() || id != cacheId) {
+        if(!idHash.contains(id.toString())) {
+          chunk.messages.append("Resource with cache id '" + id.toString() +
+                                "' has no reference in the quickid file, skipping...\n");
           continue;
         }
+        cacheId = id.toString();
       }
+      resource.cacheId = cacheId;
+    }
 
-      if(attribs.hasAttribute("source")) {
-        resource.source = attribs.value("source").toString();
-      } else {
-        resource.source = "generic";
-      }
-      if(attribs.hasAttribute("type")) {
-        resource.type = attribs.value("type").toString();
-        addToResCounts(resource.source, resource.type);
-      } else {
-        printf("Resource with cache id '%s' is missing 'type' attribute, skipping...\n",
-               resource.cacheId.toStdString().c_str());
+    if(attribs.hasAttribute("source")) {
+      resource.source = intern(sources, attribs.value("source"));
+    } else {
+      resource.source = "generic";
+    }
+    if(attribs.hasAttribute("type")) {
+      resource.type = intern(types, attribs.value("type"));
+      chunk.resCounts[qMakePair(resource.source, resource.type)]++;
+    } else {
+      chunk.messages.append("Resource with cache id '" + resource.cacheId +
+                            "' is missing 'type' attribute, skipping...\n");
+      continue;
+    }
+    if(attribs.hasAttribute("timestamp")) {
+      resource.timestamp = attribs.value("timestamp").toULongLong();
+    } else {
+      chunk.messages.append("Resource with cache id '" + resource.cacheId +
+                            "' is missing 'timestamp' attribute, skipping...\n");
+      continue;
+    }
+    resource.value = xml.readElementText();
+    if(resource.type == "cover"   || resource.type == "screenshot" ||
+       resource.type == "wheel"   || resource.type == "marquee"  ||
+       resource.type == "texture" || resource.type == "video"  ||
+       resource.type == "manual") {
+      if(!fileEntries.contains(cachePath + "/" + resource.value)) {
+        chunk.messages.append("Source file '" + resource.value + "' missing, skipping entry...\n");
         continue;
       }
-      if(attribs.hasAttribute("timestamp")) {
-        resource.timestamp = attribs.value("timestamp").toULongLong();
-      } else {
-        printf("Resource with cache id '%s' is missing 'timestamp' attribute, skipping...\n",
-               resource.cacheId.toStdString().c_str());
+    }
+
+    chunk.resources.append(resource);
+  }
+  chunk.error = xml.hasError();
+  return chunk;
+}
+
+// Splits db.xml at <resource> elements into ranges of at least 'chunkSize' bytes. Element
+// text and attributes are always escaped, so the tag can not occur elsewhere
+static QList<int> xmlChunkBounds(const QByteArray &raw, const int chunkSize)
+{
+  const QByteArray tag = "<resource ";
+  QList<int> bounds = { 0 };
+  int bound = raw.indexOf(tag, qMax(1, chunkSize));
+  while(bound != -1) {
+    bounds.append(bound);
+    bound = raw.indexOf(tag, bound + qMax(1, chunkSize));
+  }
+  bounds.append(raw.size());
+  return bounds;
+}
+
+// Parses range 'a' of the ranges from xmlChunkBounds(). Every range but the first and last
+// is wrapped in its own root element so it parses on its own
+static XmlChunk parseXmlRange(const QByteArray &raw, const QList<int> &bounds, const int a,
+                              const QString &cachePath, const QSet<QString> &fileEntries,
+                              const QMap<QString, bool> &idHash)
+{
+  return parseXmlChunk(raw.constData() + bounds.at(a), bounds.at(a + 1) - bounds.at(a),
+                       a > 0, a < bounds.size() - 2, cachePath, fileEntries, idHash);
+}
+
+bool Cache::readXml(QFile &cacheFile, const QSet<QString> &fileEntries,
+                    const QMap<QString, bool> &idHash)
+{
+  QByteArray buffer;
+  const qint64 size = cacheFile.size();
+  uchar *mapped = cacheFile.map(0, size);
+  if(mapped == nullptr) {
+    buffer = cacheFile.readAll();
+  }
+  const char *data = (mapped != nullptr?reinterpret_cast<const char *>(mapped):buffer.constData());
+  QByteArray raw = QByteArray::fromRawData(data, (mapped != nullptr?size:buffer.size()));
+  if(subsetLoad) {
+    raw = filterXmlSubset(raw, idHash);
+  }
+
+  // One range per thread
+  int threads = QThread::idealThreadCount();
+  if(raw.size() < XMLCHUNKMIN * 2 || threads < 2) {
+    threads = 1;
+  }
+  const QList<int> bounds = xmlChunkBounds(raw, threads == 1?raw.size():raw.size() / threads);
+
+  const QString cachePath = cacheDir.absolutePath();
+  QList<QFuture<XmlChunk> > futures;
+  for(int a = 0; a < bounds.size() - 1; ++a) {
+    futures.append(QtConcurrent::run([&raw, &bounds, a, &cachePath, &fileEntries, &idHash]() {
+      return parseXmlRange(raw, bounds, a, cachePath, fileEntries, idHash);
+    }));
+  }
+
+  // Merge in document order so the result is identical to a sequential parse. Types and
+  // sources are interned once more, as each range got its own copies
+  bool ok = true;
+  QHash<QString, QString> interned;
+  auto intern = [&interned](QString &string) {
+    auto it = interned.constFind(string);
+    if(it == interned.constEnd()) {
+      interned.insert(string, string);
+    } else {
+      string = it.value();
+    }
+  };
+  for(auto &future: futures) {
+    // Later ranges still have to finish, they reference locals of this function
+    XmlChunk chunk = future.result();
+    if(!ok) {
+      continue;
+    }
+    for(const auto &message: std::as_const(chunk.messages)) {
+      printf("%s", message.toStdString().c_str());
+    }
+    for(auto it = chunk.resCounts.cbegin(); it != chunk.resCounts.cend(); ++it) {
+      addToResCounts(it.key().first, it.key().second, it.value());
+    }
+    for(auto &resource: chunk.resources) {
+      intern(resource.type);
+      intern(resource.source);
+      insertResource(resource);
+    }
+    if(chunk.error) {
+      ok = false;
+    }
+  }
+
+  if(mapped != nullptr) {
+    cacheFile.unmap(mapped);
+  }
+  return ok;
+}
+
+// Copies the <resource> elements of the cache ids in 'idHash' into a document of their own.
+// Only the id attribute is looked at, so skipping an element costs little more than the
+// scan for the next tag
+QByteArray Cache::filterXmlSubset(const QByteArray &raw, const QMap<QString, bool> &idHash)
+{
+  QSet<QByteArray> ids;
+  for(auto it = idHash.cbegin(); it != idHash.cend(); ++it) {
+    ids.insert(it.key().toUtf8());
+  }
+  const QByteArray tag = "<resource ";
+  const QByteArray idAttrib = "id=\"";
+  QByteArray subset = "<resources>\n";
+  int pos = raw.indexOf(tag);
+  while(pos != -1) {
+    const int next = raw.indexOf(tag, pos + tag.size());
+    int elementEnd = next;
+    if(elementEnd == -1) {
+      elementEnd = raw.indexOf("</resources>", pos);
+      if(elementEnd == -1) {
+        elementEnd = raw.size();
+      }
+    }
+    const int idStart = pos + tag.size() + idAttrib.size();
+    bool keep = true;
+    // Elements of old caches carry a 'sha1' attribute instead, the parser sorts those out
+    if(idStart <= elementEnd &&
+       memcmp(raw.constData() + pos + tag.size(), idAttrib.constData(), idAttrib.size()) == 0) {
+      const int idEnd = raw.indexOf('"', idStart);
+      keep = idEnd != -1 && idEnd < elementEnd &&
+             ids.contains(QByteArray::fromRawData(raw.constData() + idStart, idEnd - idStart));
+    }
+    if(keep) {
+      subset.append(raw.constData() + pos, elementEnd - pos);
+    }
+    pos = next;
+  }
+  subset.append("</resources>\n");
+  return subset;
+}
+
+bool Cache::readBinary(QFile &cacheFile, const QSet<QString> &fileEntries,
+                       const QMap<QString, bool> &idHash,
+                       const std::function<void(Resource &)> &handleResource)
+{
+  // The file is mapped rather than read so the raw bytes never need their own heap copy
+  const qint64 size = cacheFile.size();
+  uchar *data = cacheFile.map(0, size);
+  if(data == nullptr) {
+    return false;
+  }
+  const uchar *pos = data;
+  const uchar *end = data + size;
+  auto readU32 = [&](quint32 &value) {
+    if(end - pos < 4) {
+      return false;
+    }
+    value = qFromLittleEndian<quint32>(pos);
+    pos += 4;
+    return true;
+  };
+  auto readI64 = [&](qint64 &value) {
+    if(end - pos < 8) {
+      return false;
+    }
+    value = qFromLittleEndian<qint64>(pos);
+    pos += 8;
+    return true;
+  };
+  auto readString = [&](QString &value) {
+    quint32 length = 0;
+    if(!readU32(length) || end - pos < length) {
+      return false;
+    }
+    value = QString::fromUtf8(reinterpret_cast<const char *>(pos), length);
+    pos += length;
+    return true;
+  };
+  // Compressed values are kept as they are, they are only expanded when used
+  auto readValue = [&](Resource &resource) {
+    quint32 length = 0;
+    if(!readU32(length) || end - pos < (length & ~BINPACKED)) {
+      return false;
+    }
+    if(length & BINPACKED) {
+      length &= ~BINPACKED;
+      resource.packed = QByteArray(reinterpret_cast<const char *>(pos), length);
+      resource.value = QString();
+    } else {
+      resource.value = QString::fromUtf8(reinterpret_cast<const char *>(pos), length);
+    }
+    pos += length;
+    return true;
+  };
+
+  bool ok = false;
+  quint32 magic = 0;
+  quint32 version = 0;
+  quint32 stringCount = 0;
+  if(readU32(magic) && magic == BINMAGIC &&
+     readU32(version) && (version == 1 || version == BINVERSION) &&
+     readU32(stringCount)) {
+    // Types, sources and cache ids are stored once and shared by all resources using them
+    QVector<QString> strings(stringCount);
+    ok = true;
+    for(quint32 a = 0; ok && a < stringCount; ++a) {
+      ok = readString(strings[a]);
+    }
+    // Looked up once per string rather than once per resource
+    QVector<bool> known(stringCount);
+    for(quint32 a = 0; ok && a < stringCount; ++a) {
+      known[a] = idHash.contains(strings.at(a));
+    }
+    quint32 resCount = 0;
+    ok = ok && readU32(resCount);
+    for(quint32 a = 0; ok && a < resCount; ++a) {
+      quint32 cacheIdIdx = 0;
+      quint32 typeIdx = 0;
+      quint32 sourceIdx = 0;
+      Resource resource;
+      ok = readU32(cacheIdIdx) && cacheIdIdx < stringCount &&
+           readU32(typeIdx) && typeIdx < stringCount &&
+           readU32(sourceIdx) && sourceIdx < stringCount &&
+           readI64(resource.timestamp);
+      if(ok && !known.at(cacheIdIdx)) {
+        // Step over the value without decoding it, a subset load skips nearly everything
+        quint32 length = 0;
+        ok = readU32(length) && end - pos >= (length & ~BINPACKED);
+        length &= ~BINPACKED;
+        pos += (ok?length:0);
+        if(ok && !subsetLoad) {
+          printf("Resource with cache id '%s' has no reference in the quickid file, skipping...\n",
+                 strings.at(cacheIdIdx).toStdString().c_str());
+        }
         continue;
       }
-      resource.value = xml.readElementText();
+      ok = ok && readValue(resource);
+      if(!ok) {
+        break;
+      }
+      resource.cacheId = strings.at(cacheIdIdx);
+      resource.type = strings.at(typeIdx);
+      resource.source = strings.at(sourceIdx);
       if(resource.type == "cover"   || resource.type == "screenshot" ||
          resource.type == "wheel"   || resource.type == "marquee"  ||
          resource.type == "texture" || resource.type == "video"  ||
@@ -226,25 +961,808 @@ bool Cache::read()
           continue;
         }
       }
-
-      resources.append(resource);
+      handleResource(resource);
     }
+  } else {
+    printf("'%s' has an unknown format or version... ", cacheFile.fileName().toStdString().c_str());
+  }
 
-    cacheFile.close();
-    resAtLoad = resources.length();
-    printf("\033[1;32mDone!\033[0m\n");
-    printf("Successfully parsed %d resources!\n\n", resources.length());
-    return true;
+  cacheFile.unmap(data);
+  return ok;
+}
+
+QString Cache::cacheFileName(const QString &format)
+{
+  if(format == "binary") {
+    return cacheDir.absolutePath() + "/db.bin";
+  } else if(format == "sqlite") {
+    return cacheDir.absolutePath() + "/db.sqlite";
   }
-  return false;
+  return cacheDir.absolutePath() + "/db.xml";
 }
 
-void Cache::printPriorities(QString cacheId)
+// Connections can't be shared between threads, so each thread gets its own
+QSqlDatabase Cache::database()
 {
-  GameEntry game;
-  game.cacheId = cacheId;
-  fillBlanks(game);
-  printf("\033[1;34mCurrent resource priorities for this rom:\033[0m\n");
+  QString connection = "resourcecache" + QString::number((quintptr)this) + "_" +
+    QString::number((quintptr)QThread::currentThreadId());
+  if(QSqlDatabase::contains(connection)) {
+    return QSqlDatabase::database(connection);
+  }
+  {
+    QMutexLocker locker(&dbConnectionsMutex);
+    dbConnections.append(connection);
+  }
+  QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+  db.setDatabaseName(cacheFileName("sqlite"));
+  if(!db.open()) {
+    printf("ERROR: Could not open/create the resource cache database '%s'.\n",
+           db.databaseName().toStdString().c_str());
+    qDebug() << db.lastError();
+    return db;
+  }
+  QSqlQuery query(db);
+  query.exec("PRAGMA journal_mode=WAL");
+  query.exec("PRAGMA synchronous=NORMAL");
+  query.exec("PRAGMA busy_timeout=10000");
+  if(!query.exec("CREATE TABLE IF NOT EXISTS resources ("
+                 "cacheid TEXT NOT NULL, type TEXT NOT NULL, source TEXT NOT NULL, "
+                 "timestamp INTEGER NOT NULL, value TEXT NOT NULL)") ||
+     !query.exec("CREATE INDEX IF NOT EXISTS resourcelookup ON resources(cacheid, type, source)") ||
+     !query.exec("CREATE TABLE IF NOT EXISTS quickids ("
+                 "filepath TEXT PRIMARY KEY, timestamp INTEGER NOT NULL, cacheid TEXT NOT NULL, "
+                 "filekey TEXT)") ||
+     // Databases created before file keys were recorded
+     (!db.record("quickids").contains("filekey") &&
+      !query.exec("ALTER TABLE quickids ADD COLUMN filekey TEXT"))) {
+    printf("ERROR: Error creating the resource cache database tables.\n");
+    qDebug() << query.lastError();
+  }
+  return db;
+}
+
+void Cache::closeDatabase()
+{
+  QMutexLocker locker(&dbConnectionsMutex);
+  for(const auto &connection: std::as_const(dbConnections)) {
+    QSqlDatabase::removeDatabase(connection);
+  }
+  dbConnections.clear();
+}
+
+// Only the per source / type counts are read, resources are loaded per rom by findBucket()
+bool Cache::readSqliteSummary()
+{
+  printf("Reading resource cache database summary, please wait... "); fflush(stdout);
+  resAtLoad = readSqliteCounts();
+  if(resAtLoad < 0) {
+    printf("\033[1;31mFailed!\033[0m\n");
+    return false;
+  }
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  int roms = 0;
+  if(query.exec("SELECT COUNT(DISTINCT cacheid) FROM resources") && query.next()) {
+    roms = query.value(0).toInt();
+  }
+  printf("\033[1;32mDone!\033[0m\n");
+  printf("Database holds %d resources for %d roms, they will be loaded as needed.\n\n",
+         resAtLoad, roms);
+  return resAtLoad > 0;
+}
+
+// Fills the per source / type counts from the database, as a lazily loaded cache only holds
+// the roms looked up so far. Returns the number of resources or -1 on errors
+int Cache::readSqliteCounts()
+{
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  if(!query.exec("SELECT source, type, COUNT(*) FROM resources GROUP BY source, type")) {
+    qDebug() << query.lastError();
+    return -1;
+  }
+  resCountsMap.clear();
+  int total = 0;
+  while(query.next()) {
+    int count = query.value(2).toInt();
+    addToResCounts(query.value(0).toString(), query.value(1).toString(), count);
+    total += count;
+  }
+  return total;
+}
+
+bool Cache::readSqlite(const QSet<QString> &fileEntries, const QMap<QString, bool> &idHash,
+                       const std::function<void(Resource &)> &handleResource)
+{
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  if(!query.exec("SELECT cacheid, type, source, timestamp, value FROM resources ORDER BY cacheid")) {
+    qDebug() << query.lastError();
+    return false;
+  }
+  while(query.next()) {
+    Resource resource;
+    resource.cacheId = query.value(0).toString();
+    resource.type = query.value(1).toString();
+    resource.source = query.value(2).toString();
+    resource.timestamp = query.value(3).toLongLong();
+    resource.value = query.value(4).toString();
+    if(!idHash.contains(resource.cacheId)) {
+      printf("Resource with cache id '%s' has no reference in the quickid table, skipping...\n",
+             resource.cacheId.toStdString().c_str());
+      continue;
+    }
+    if(resource.type == "cover"   || resource.type == "screenshot" ||
+       resource.type == "wheel"   || resource.type == "marquee"  ||
+       resource.type == "texture" || resource.type == "video"  ||
+       resource.type == "manual") {
+      if(!fileEntries.contains(cacheDir.absolutePath() + "/" + resource.value)) {
+        printf("Source file '%s' missing, skipping entry...\n",
+               resource.value.toStdString().c_str());
+        continue;
+      }
+    }
+    handleResource(resource);
+  }
+  return true;
+}
+
+void Cache::loadBucket(const QString &cacheId)
+{
+  loadedIds.insert(cacheId);
+  QSqlQuery query(database());
+  query.setForwardOnly(true);
+  query.prepare("SELECT type, source, timestamp, value FROM resources WHERE cacheid=:cacheid");
+  query.bindValue(":cacheid", cacheId);
+  if(!query.exec()) {
+    qDebug() << query.lastError();
+    return;
+  }
+  while(query.next()) {
+    Resource resource;
+    resource.cacheId = cacheId;
+    resource.type = query.value(0).toString();
+    resource.source = query.value(1).toString();
+    resource.timestamp = query.value(2).toLongLong();
+    resource.value = query.value(3).toString();
+    if(resource.type == "cover"   || resource.type == "screenshot" ||
+       resource.type == "wheel"   || resource.type == "marquee"  ||
+       resource.type == "texture" || resource.type == "video"  ||
+       resource.type == "manual") {
+      if(!QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
+        continue;
+      }
+    }
+    // Resources already in memory are newer than their row, if that was written at all
+    bool inMemory = false;
+    auto it = resources.constFind(cacheId);
+    if(it != resources.constEnd()) {
+      for(const auto &res: it.value().resources) {
+        if(res.type == resource.type && res.source == resource.source) {
+          inMemory = true;
+          break;
+        }
+      }
+    }
+    if(!inMemory) {
+      insertResource(resource);
+    }
+  }
+}
+
+void Cache::sqliteAdd(const Resource &resource)
+{
+  QSqlQuery query(database());
+  query.prepare("INSERT INTO resources (cacheid, type, source, timestamp, value)"
+                " VALUES (:cacheid, :type, :source, :timestamp, :value)");
+  query.bindValue(":cacheid", resource.cacheId);
+  query.bindValue(":type", resource.type);
+  query.bindValue(":source", resource.source);
+  query.bindValue(":timestamp", resource.timestamp);
+  query.bindValue(":value", resource.text());
+  if(!query.exec()) {
+    printf("ERROR: Could not add resource to the resource cache database.\n");
+    qDebug() << query.lastError();
+  }
+}
+
+void Cache::sqliteRemove(const QString &cacheId, const QString &type, const QString &source)
+{
+  QSqlQuery query(database());
+  query.prepare("DELETE FROM resources WHERE cacheid=:cacheid" +
+                QString(type.isEmpty()?"":" AND type=:type") +
+                QString(source.isEmpty()?"":" AND source=:source"));
+  query.bindValue(":cacheid", cacheId);
+  if(!type.isEmpty()) {
+    query.bindValue(":type", type);
+  }
+  if(!source.isEmpty()) {
+    query.bindValue(":source", source);
+  }
+  if(!query.exec()) {
+    printf("ERROR: Could not remove resources from the resource cache database.\n");
+    qDebug() << query.lastError();
+  }
+}
+
+void Cache::sqliteQuickId(const QString &filePath, const QPair<qint64, QString> &quickId,
+                          const QString &fileKey)
+{
+  QSqlQuery query(database());
+  query.prepare("INSERT OR REPLACE INTO quickids (filepath, timestamp, cacheid, filekey)"
+                " VALUES (:filepath, :timestamp, :cacheid, :filekey)");
+  query.bindValue(":filepath", filePath);
+  query.bindValue(":timestamp", quickId.first);
+  query.bindValue(":cacheid", quickId.second);
+  query.bindValue(":filekey", fileKey);
+  if(!query.exec()) {
+    printf("ERROR: Could not add quick id to the resource cache database.\n");
+    qDebug() << query.lastError();
+  }
+}
+
+// Applies queued journal records to the database in a single transaction
+void Cache::applySqlite(const QList<QByteArray> &records)
+{
+  QSqlDatabase db = database();
+  if(!db.isOpen()) {
+    return;
+  }
+  db.transaction();
+  QPair<qint64, QString> quickId;
+  for(const auto &record: records) {
+    QDataStream in(record);
+    quint8 op = 0;
+    in >> op;
+    if(op == JOURNALADD) {
+      Resource resource;
+      in >> resource.cacheId >> resource.type >> resource.source
+         >> resource.value >> resource.timestamp;
+      sqliteAdd(resource);
+    } else if(op == JOURNALREMOVE) {
+      QString cacheId;
+      QString type;
+      QString source;
+      in >> cacheId >> type >> source;
+      sqliteRemove(cacheId, type, source);
+    } else if(op == JOURNALQUICKID) {
+      QString filePath;
+      in >> filePath >> quickId.first >> quickId.second;
+      sqliteQuickId(filePath, quickId, QString());
+    } else if(op == JOURNALFILEKEY) {
+      // Always follows the quick id record of the same file
+      QString filePath;
+      QString fileKey;
+      in >> filePath >> fileKey;
+      sqliteQuickId(filePath, quickId, fileKey);
+    }
+  }
+  if(!db.commit()) {
+    printf("ERROR: Could not save the changes to the resource cache database.\n");
+    qDebug() << db.lastError();
+  }
+}
+
+// When only a subset of the roms is loaded, so are only the records of their cache ids.
+// Those are the ones in 'idHash' and the ones of quick ids journaled for the queued roms,
+// which always come before the resources of their rom
+int Cache::replayJournal(QMap<QString, bool> &idHash)
+{
+  QFile file(cacheDir.absolutePath() + "/db.journal");
+  if(!file.exists() || !file.open(QIODevice::ReadWrite)) {
+    return 0;
+  }
+  QDataStream in(&file);
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version;
+  if(magic != JOURNALMAGIC || version != JOURNALVERSION) {
+    file.close();
+    if(file.size() > 0) {
+      printf("\033[1;33mCache journal '%s' has an unknown format, moving it aside...\033[0m\n\n",
+             file.fileName().toStdString().c_str());
+      QFile::remove(file.fileName() + ".invalid");
+      QFile::rename(file.fileName(), file.fileName() + ".invalid");
+    }
+    return 0;
+  }
+
+  printf("Replaying cache journal, please wait... "); fflush(stdout);
+  int replayed = 0;
+  qint64 validEnd = file.pos();
+  while(!in.atEnd()) {
+    quint32 length = 0;
+    in >> length;
+    if(in.status() != QDataStream::Ok || length > file.size() - file.pos()) {
+      break;
+    }
+    QByteArray record(length, Qt::Uninitialized);
+    if(in.readRawData(record.data(), length) != (int)length) {
+      break;
+    }
+    validEnd = file.pos();
+
+    QDataStream recordIn(record);
+    quint8 op = 0;
+    recordIn >> op;
+    if(op == JOURNALADD) {
+      Resource resource;
+      recordIn >> resource.cacheId >> resource.type >> resource.source
+               >> resource.value >> resource.timestamp;
+      if(subsetLoad && !idHash.contains(resource.cacheId)) {
+        continue;
+      }
+      if(resource.type == "cover"   || resource.type == "screenshot" ||
+         resource.type == "wheel"   || resource.type == "marquee"  ||
+         resource.type == "texture" || resource.type == "video"  ||
+         resource.type == "manual") {
+        if(!QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
+          continue;
+        }
+      }
+      // A journal that survived a completed write may repeat resources already in db.xml.
+      // Lazily loaded roms are left to loadBucket(), which then finds the replayed rows
+      // in the database along with all the others of the rom
+      if(!lazyLoad) {
+        removeMatching(resource.cacheId, resource.type, resource.source);
+        insertResource(resource);
+        addToResCounts(resource.source, resource.type);
+      }
+      if(sqliteBacked) {
+        journalRemove(resource.cacheId, resource.type, resource.source);
+        journalAdd(resource);
+      }
+    } else if(op == JOURNALREMOVE) {
+      QString cacheId;
+      QString type;
+      QString source;
+      recordIn >> cacheId >> type >> source;
+      if(subsetLoad && !idHash.contains(cacheId)) {
+        continue;
+      }
+      if(!lazyLoad) {
+        removeMatching(cacheId, type, source);
+      }
+      if(sqliteBacked) {
+        journalRemove(cacheId, type, source);
+      }
+    } else if(op == JOURNALQUICKID) {
+      QString filePath;
+      QPair<qint64, QString> pair;
+      recordIn >> filePath >> pair.first >> pair.second;
+      if(subsetLoad) {
+        if(!subsetFiles.contains(filePath)) {
+          continue;
+        }
+        idHash[pair.second] = true;
+      }
+      quickIds[filePath] = pair;
+      if(sqliteBacked) {
+        journalQuickId(filePath, pair);
+      }
+    } else if(op == JOURNALFILEKEY) {
+      // Always follows the quick id record of the same file
+      QString filePath;
+      QString fileKey;
+      recordIn >> filePath >> fileKey;
+      if(subsetLoad && !subsetFiles.contains(filePath)) {
+        continue;
+      }
+      addFileKey(filePath, fileKey);
+      if(sqliteBacked) {
+        journalQuickId(filePath, quickIds.value(filePath), fileKey);
+      }
+    } else {
+      continue;
+    }
+    replayed++;
+  }
+  if(validEnd < file.size()) {
+    // Drop the torn tail so new records aren't appended after garbage
+    file.resize(validEnd);
+  }
+  file.close();
+  printf("\033[1;32mDone!\033[0m\n");
+  if(sqliteBacked) {
+    // Everything replayed goes straight into the database, the journal is no longer needed
+    flushJournal();
+    resetJournal();
+    printf("Replayed %d journal entries into the cache database.\n\n", replayed);
+  } else {
+    printf("Replayed %d journal entries, cache now holds %d resources for %d roms.\n\n",
+           replayed, resourceCount(), resources.size());
+  }
+  return replayed;
+}
+
+bool Cache::startJournal()
+{
+  if(sqliteBacked) {
+    // The database is written to directly and is crash safe on its own
+    return true;
+  }
+  QMutexLocker locker(&flushMutex);
+  if(journalFile.isOpen()) {
+    return true;
+  }
+  journalFile.setFileName(cacheDir.absolutePath() + "/db.journal");
+  bool isNew = !journalFile.exists() || journalFile.size() == 0;
+  if(!journalFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    printf("\033[1;33mCouldn't open cache journal '%s' for writing, new resources will "
+           "only be saved at the end of the run.\033[0m\n\n",
+           journalFile.fileName().toStdString().c_str());
+    return false;
+  }
+  if(isNew) {
+    QDataStream out(&journalFile);
+    out << JOURNALMAGIC << JOURNALVERSION;
+    journalFile.flush();
+  }
+  return true;
+}
+
+// Callers hold the cache lock, so the record is only queued for flushJournal()
+void Cache::appendJournal(const QByteArray &record)
+{
+  QMutexLocker locker(&journalMutex);
+  pendingRecords.append(record);
+}
+
+// Writes the queued records to the journal, or to the database when the cache lives in
+// one. Called once a game is stored and before the cache is written, never under the
+// cache lock, so the scraper threads don't wait on each other's disk writes
+void Cache::flushJournal()
+{
+  QMutexLocker flushLocker(&flushMutex);
+  QList<QByteArray> records;
+  {
+    QMutexLocker locker(&journalMutex);
+    records.swap(pendingRecords);
+  }
+  if(records.isEmpty()) {
+    return;
+  }
+  if(sqliteBacked) {
+    applySqlite(records);
+    return;
+  }
+  if(!journalFile.isOpen()) {
+    return;
+  }
+  QDataStream out(&journalFile);
+  for(const auto &record: std::as_const(records)) {
+    out << (quint32)record.size();
+    out.writeRawData(record.constData(), record.size());
+  }
+  journalFile.flush();
+}
+
+void Cache::journalAdd(const Resource &resource)
+{
+  if(!sqliteBacked && !journalFile.isOpen()) {
+    return;
+  }
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out << JOURNALADD << resource.cacheId << resource.type << resource.source
+      << resource.text() << resource.timestamp;
+  appendJournal(record);
+}
+
+void Cache::journalRemove(const QString &cacheId, const QString &type, const QString &source)
+{
+  if(!sqliteBacked && !journalFile.isOpen()) {
+    return;
+  }
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out << JOURNALREMOVE << cacheId << type << source;
+  appendJournal(record);
+}
+
+void Cache::journalQuickId(const QString &filePath, const QPair<qint64, QString> &quickId,
+                           const QString &fileKey)
+{
+  if(!sqliteBacked && !journalFile.isOpen()) {
+    return;
+  }
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out << JOURNALQUICKID << filePath << quickId.first << quickId.second;
+  appendJournal(record);
+  // A record of its own, so journals stay readable by versions that don't know file keys
+  if(!fileKey.isEmpty()) {
+    QByteArray keyRecord;
+    QDataStream keyOut(&keyRecord, QIODevice::WriteOnly);
+    keyOut << JOURNALFILEKEY << filePath << fileKey;
+    appendJournal(keyRecord);
+  }
+}
+
+// Called once db.xml / db.bin holds everything, so the journal has nothing left to replay
+void Cache::resetJournal()
+{
+  QMutexLocker locker(&flushMutex);
+  {
+    QMutexLocker pendingLocker(&journalMutex);
+    pendingRecords.clear();
+  }
+  if(journalFile.isOpen()) {
+    journalFile.resize(0);
+    QDataStream out(&journalFile);
+    out << JOURNALMAGIC << JOURNALVERSION;
+    journalFile.flush();
+  } else {
+    QFile::remove(cacheDir.absolutePath() + "/db.journal");
+  }
+}
+
+QSet<QString> Cache::scanMedia(const bool rescanAll)
+{
+  QMutexLocker locker(&manifestMutex);
+  QHash<QString, MediaDir> manifest;
+  QFile manifestFile(cacheDir.absolutePath() + "/media.manifest");
+  if(!rescanAll && manifestFile.open(QIODevice::ReadOnly)) {
+    QDataStream in(&manifestFile);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if(magic == MANIFESTMAGIC && version == MANIFESTVERSION) {
+      in >> manifest;
+    }
+    if(in.status() != QDataStream::Ok) {
+      manifest.clear();
+    }
+    manifestFile.close();
+  }
+
+  // Folders with an unchanged mtime have had no files added or removed, so their file
+  // list is taken from the manifest as is. Only changed folders are listed again
+  mediaDirs = manifest;
+  QHash<QString, MediaDir> scanned;
+  int rescanned = 0;
+  QStringList binTypes;
+  binTypes << "cover" << "screenshot" << "wheel" << "marquee" << "texture" << "video" << "manual";
+  for(auto const &t: binTypes) {
+    scanMediaDir(t + "s", scanned, rescanAll, rescanned);
+  }
+  mediaDirs = scanned;
+  dirtyMediaDirs.clear();
+  manifestLoaded = true;
+  if(rescanned > 0 || manifest.size() != scanned.size()) {
+    // Written right away, so an aborted run doesn't have to list the same folders again
+    for(auto it = scanned.cbegin(); it != scanned.cend(); ++it) {
+      dirtyMediaDirs.insert(it.key());
+    }
+  }
+
+  QSet<QString> fileEntries;
+  const QString cachePath = cacheDir.absolutePath();
+  for(auto it = mediaDirs.cbegin(); it != mediaDirs.cend(); ++it) {
+    const QString dirPath = cachePath + "/" + it.key() + "/";
+    for(auto fileIt = it.value().files.cbegin(); fileIt != it.value().files.cend(); ++fileIt) {
+      fileEntries.insert(dirPath + fileIt.key());
+    }
+  }
+  locker.unlock();
+  writeManifest();
+  return fileEntries;
+}
+
+void Cache::scanMediaDir(const QString &dirPath, QHash<QString, MediaDir> &scanned,
+                         const bool rescanAll, int &rescanned)
+{
+  QFileInfo dirInfo(cacheDir.absolutePath() + "/" + dirPath);
+  if(!dirInfo.isDir()) {
+    return;
+  }
+  qint64 mtime = dirInfo.lastModified().toMSecsSinceEpoch();
+  MediaDir mediaDir;
+  auto it = mediaDirs.constFind(dirPath);
+  if(!rescanAll && it != mediaDirs.constEnd() && it.value().mtime == mtime) {
+    mediaDir = it.value();
+  } else {
+    rescanned++;
+    mediaDir.mtime = mtime;
+    QDir dir(dirInfo.absoluteFilePath());
+    const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    for(const auto &entry: entries) {
+      if(entry.isDir()) {
+        mediaDir.subDirs.append(entry.fileName());
+      } else {
+        mediaDir.files.insert(entry.fileName(),
+                              qMakePair(entry.size(), entry.lastModified().toMSecsSinceEpoch()));
+      }
+    }
+  }
+  scanned.insert(dirPath, mediaDir);
+  for(const auto &subDir: std::as_const(mediaDir.subDirs)) {
+    scanMediaDir(dirPath + "/" + subDir, scanned, rescanAll, rescanned);
+  }
+}
+
+void Cache::manifestAdd(const QString &fileName)
+{
+  QMutexLocker locker(&manifestMutex);
+  if(!manifestLoaded) {
+    return;
+  }
+  QFileInfo info(fileName);
+  if(!info.exists()) {
+    return;
+  }
+  QString dirPath = cacheDir.relativeFilePath(info.absolutePath());
+  mediaDirs[dirPath].files.insert(info.fileName(),
+                                  qMakePair(info.size(), info.lastModified().toMSecsSinceEpoch()));
+  dirtyMediaDirs.insert(dirPath);
+  // A new source folder also has to be linked to its parent
+  while(dirPath.contains('/')) {
+    QString parentPath = dirPath.left(dirPath.lastIndexOf('/'));
+    QString subDir = dirPath.mid(parentPath.length() + 1);
+    MediaDir &parent = mediaDirs[parentPath];
+    if(parent.subDirs.contains(subDir)) {
+      break;
+    }
+    parent.subDirs.append(subDir);
+    dirtyMediaDirs.insert(parentPath);
+    dirPath = parentPath;
+  }
+}
+
+void Cache::manifestRemove(const QString &fileName)
+{
+  QMutexLocker locker(&manifestMutex);
+  if(!manifestLoaded) {
+    return;
+  }
+  QFileInfo info(fileName);
+  QString dirPath = cacheDir.relativeFilePath(info.absolutePath());
+  auto it = mediaDirs.find(dirPath);
+  if(it != mediaDirs.end()) {
+    it.value().files.remove(info.fileName());
+    dirtyMediaDirs.insert(dirPath);
+  }
+}
+
+void Cache::writeManifest()
+{
+  QMutexLocker locker(&manifestMutex);
+  if(!manifestLoaded || dirtyMediaDirs.isEmpty()) {
+    return;
+  }
+  // Our own changes have been recorded as they happened, the folders only need their new mtime
+  for(const auto &dirPath: std::as_const(dirtyMediaDirs)) {
+    QFileInfo dirInfo(cacheDir.absolutePath() + "/" + dirPath);
+    if(dirInfo.isDir()) {
+      mediaDirs[dirPath].mtime = dirInfo.lastModified().toMSecsSinceEpoch();
+    }
+  }
+  QFile manifestFile(cacheDir.absolutePath() + "/media.manifest.tmp");
+  if(!manifestFile.open(QIODevice::WriteOnly)) {
+    printf("Couldn't write '%s', the media folders will be listed again on next run.\n",
+           manifestFile.fileName().toStdString().c_str());
+    return;
+  }
+  QDataStream out(&manifestFile);
+  out << MANIFESTMAGIC << MANIFESTVERSION << mediaDirs;
+  manifestFile.close();
+  QFile::remove(cacheDir.absolutePath() + "/media.manifest");
+  if(manifestFile.rename(cacheDir.absolutePath() + "/media.manifest")) {
+    dirtyMediaDirs.clear();
+  }
+}
+
+// Moves a media file into the content addressed blob store and replaces it with a hard
+// link to the blob. A blob is shared by every resource with identical content
+void Cache::dedupMedia(const QString &fileName, const QByteArray &data, const QString &digest)
+{
+  QFileInfo info(fileName);
+  if(!info.exists() || info.isSymLink()) {
+    // Symbolic links point to local files outside of the cache or already to a blob
+    return;
+  }
+  QString hex = digest;
+  if(hex.isEmpty()) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if(data.isEmpty()) {
+      QFile f(fileName);
+      if(!f.open(QIODevice::ReadOnly) || !hash.addData(&f)) {
+        return;
+      }
+    } else {
+      hash.addData(data);
+    }
+    hex = hash.result().toHex();
+  }
+  QString blobDir = cacheDir.absolutePath() + "/blobs/" + hex.left(2);
+  QString blobFile = blobDir + "/" + hex;
+  cacheDir.mkpath(blobDir);
+
+  QByteArray nativeFile = QFile::encodeName(fileName);
+  QByteArray nativeBlob = QFile::encodeName(blobFile);
+  if(::link(nativeFile.constData(), nativeBlob.constData()) == 0) {
+    // First file with this content, it simply becomes the blob
+    return;
+  }
+  if(errno == EEXIST) {
+    // Swap the file for a link to the existing blob in one atomic rename
+    QByteArray nativeTmp = QFile::encodeName(fileName + ".dedup");
+    ::unlink(nativeTmp.constData());
+    if(::link(nativeBlob.constData(), nativeTmp.constData()) == 0 &&
+       ::rename(nativeTmp.constData(), nativeFile.constData()) == 0) {
+      return;
+    }
+    ::unlink(nativeTmp.constData());
+  }
+  // No hard links on this file system, fall back to a symbolic link. It is relative, so
+  // the cache folder can still be moved or mounted elsewhere
+  if(!QFileInfo::exists(blobFile) && !QFile::rename(fileName, blobFile)) {
+    return;
+  }
+  QFile::remove(fileName);
+  const QString target = QDir(info.absolutePath()).relativeFilePath(blobFile);
+  if(::symlink(QFile::encodeName(target).constData(), nativeFile.constData()) != 0) {
+    // Better a copy than a media file that is gone
+    QFile::copy(blobFile, fileName);
+  }
+}
+
+// Garbage collects blobs that are no longer referenced by any media resource. Both hard
+// and symbolic links resolve to the inode of their blob, so that is what is compared
+int Cache::collectBlobs()
+{
+  QDir blobsDir(cacheDir.absolutePath() + "/blobs");
+  if(!blobsDir.exists() || subsetLoad || partialShards || lazyLoad) {
+    // Only a fully loaded cache knows every resource that references a blob
+    return 0;
+  }
+  QSet<QPair<dev_t, ino_t> > referenced;
+  for(const auto &bucket: std::as_const(resources)) {
+    for(const auto &res: bucket.resources) {
+      struct stat mediaStat;
+      if(isMedia(res.typeId) &&
+         ::stat(QFile::encodeName(cacheDir.absolutePath() + "/" + res.value).constData(),
+                &mediaStat) == 0) {
+        referenced.insert(qMakePair(mediaStat.st_dev, mediaStat.st_ino));
+      }
+    }
+  }
+
+  int collected = 0;
+  QDirIterator it(blobsDir.absolutePath(), QDir::Files | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories);
+  while(it.hasNext()) {
+    QString blobFile = it.next();
+    struct stat blobStat;
+    if(::stat(QFile::encodeName(blobFile).constData(), &blobStat) != 0 ||
+       referenced.contains(qMakePair(blobStat.st_dev, blobStat.st_ino))) {
+      continue;
+    }
+    if(QFile::remove(blobFile)) {
+      collected++;
+    }
+  }
+  return collected;
+}
+
+QDataStream &operator<<(QDataStream &out, const MediaDir &mediaDir)
+{
+  out << mediaDir.mtime << mediaDir.subDirs << mediaDir.files;
+  return out;
+}
+
+QDataStream &operator>>(QDataStream &in, MediaDir &mediaDir)
+{
+  in >> mediaDir.mtime >> mediaDir.subDirs >> mediaDir.files;
+  return in;
+}
+
+void Cache::printPriorities(QString cacheId)
+{
+  GameEntry game;
+  game.cacheId = cacheId;
+  fillBlanks(game);
+  printf("\033[1;34mCurrent resource priorities for this rom:\033[0m\n");
   printf("Id:             '\033[1;32m%s\033[0m' (%s)\n",
          game.id.toStdString().c_str(),
          (game.idSrc.isEmpty()?QString("\033[1;31mmissing\033[0m"):game.idSrc).toStdString().c_str());
@@ -487,12 +2005,12 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "S") {
         printf("\033[1;34mResources connected to this rom:\033[0m\n");
         bool found = false;
-        for(const auto &res: std::as_const(resources)) {
-          if(res.cacheId == cacheId) {
+        if(ResourceBucket *bucket = findBucket(cacheId)) {
+          for(const auto &res: std::as_const(bucket->resources)) {
             printf("\033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n",
                    res.type.toStdString().c_str(),
                    res.source.toStdString().c_str(),
-                   res.value.toStdString().c_str());
+                   res.text().toStdString().c_str());
             found = true;
           }
         }
@@ -755,17 +2273,19 @@ void Cache::editResources(QSharedPointer<Queue> queue,
           } else if(!value.isEmpty() && QRegularExpression(expression).match(value).hasMatch()) {
             newRes.value = value;
             bool updated = false;
-            QMutableListIterator<Resource> it(resources);
-            while(it.hasNext()) {
-              Resource res = it.next();
-              if(res.cacheId == newRes.cacheId &&
-                 res.type == newRes.type &&
-                 res.source == newRes.source) {
-                it.remove();
-                updated = true;
+            if(ResourceBucket *bucket = findBucket(newRes.cacheId)) {
+              QMutableVectorIterator<Resource> it(bucket->resources);
+              while(it.hasNext()) {
+                Resource res = it.next();
+                if(res.type == newRes.type &&
+                   res.source == newRes.source) {
+                  it.remove();
+                  updated = true;
+                }
               }
+              pruneBucket(newRes.cacheId);
             }
-            resources.append(newRes);
+            insertResource(newRes);
             if(updated) {
               printf(">>> Updated existing ");
             } else {
@@ -781,19 +2301,20 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "d") {
         int b = 1;
         QList<int> resIds;
+        ResourceBucket *bucket = findBucket(cacheId);
         printf("\033[1;34mWhich resource id would you like to remove?\033[0m (Enter to cancel)\n");
-        for(int a = 0; a < resources.length(); ++a) {
-          if(resources.at(a).cacheId == cacheId &&
-             resources.at(a).type != "screenshot" &&
-             resources.at(a).type != "cover" &&
-             resources.at(a).type != "wheel" &&
-             resources.at(a).type != "marquee" &&
-             resources.at(a).type != "texture" &&
-             resources.at(a).type != "video" &&
-             resources.at(a).type != "manual") {
-            printf("\033[1;33m%d\033[0m) \033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n", b, resources.at(a).type.toStdString().c_str(),
-                   resources.at(a).source.toStdString().c_str(),
-                   resources.at(a).value.toStdString().c_str());
+        for(int a = 0; bucket && a < bucket->resources.length(); ++a) {
+          const Resource &res = bucket->resources.at(a);
+          if(res.type != "screenshot" &&
+             res.type != "cover" &&
+             res.type != "wheel" &&
+             res.type != "marquee" &&
+             res.type != "texture" &&
+             res.type != "video" &&
+             res.type != "manual") {
+            printf("\033[1;33m%d\033[0m) \033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n", b, res.type.toStdString().c_str(),
+                   res.source.toStdString().c_str(),
+                   res.text().toStdString().c_str());
             resIds.append(a);
             b++;
           }
@@ -812,24 +2333,23 @@ void Cache::editResources(QSharedPointer<Queue> queue,
         } else {
           int chosen = atoi(typeInput.c_str());
           if(chosen >= 1 && chosen <= resIds.length()) {
-            resources.removeAt(resIds.at(chosen - 1)); // -1 because lists start at 0
+            bucket->resources.removeAt(resIds.at(chosen - 1)); // -1 because lists start at 0
+            pruneBucket(cacheId);
             printf("<<< Removed resource id %d\n\n", chosen);
           } else {
             printf("Incorrect resource id, cancelling...\n\n");
           }
         }
       } else if(userInput == "D") {
-        QMutableListIterator<Resource> it(resources);
         bool found = false;
-        while(it.hasNext()) {
-          Resource res = it.next();
-          if(res.cacheId == cacheId) {
+        if(ResourceBucket *bucket = findBucket(cacheId)) {
+          for(const auto &res: std::as_const(bucket->resources)) {
             printf("<<< Removed \033[1;33m%s\033[0m (%s) with value '\033[1;32m%s\033[0m'\n", res.type.toStdString().c_str(),
                    res.source.toStdString().c_str(),
-                   res.value.toStdString().c_str());
-            it.remove();
+                   res.text().toStdString().c_str());
             found = true;
           }
+          resources.remove(cacheId);
         }
         if(!found)
           printf("No resources found for this rom...\n");
@@ -837,8 +2357,8 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "m") {
         printf("\033[1;34mResources from which module would you like to remove?\033[0m (Enter to cancel)\n");
         QMap<QString, int> modules;
-        for(const auto &res: std::as_const(resources)) {
-          if(res.cacheId == cacheId) {
+        if(ResourceBucket *bucket = findBucket(cacheId)) {
+          for(const auto &res: std::as_const(bucket->resources)) {
             modules[res.source] += 1;
           }
         }
@@ -858,15 +2378,16 @@ void Cache::editResources(QSharedPointer<Queue> queue,
           printf("Resource removal cancelled...\n\n");
           continue;
         } else if(modules.contains(QString(typeInput.c_str()))) {
-          QMutableListIterator<Resource> it(resources);
+          QMutableVectorIterator<Resource> it(findBucket(cacheId)->resources);
           int removed = 0;
           while(it.hasNext()) {
             Resource res = it.next();
-            if(res.cacheId == cacheId && res.source == QString(typeInput.c_str())) {
+            if(res.source == QString(typeInput.c_str())) {
               it.remove();
               removed++;
             }
           }
+          pruneBucket(cacheId);
           printf("<<< Removed %d resource(s) connected to rom from module '\033[1;32m%s\033[0m'\n\n",
                  removed, typeInput.c_str());
         } else {
@@ -875,8 +2396,8 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "t") {
         printf("\033[1;34mResources of which type would you like to remove?\033[0m (Enter to cancel)\n");
         QMap<QString, int> types;
-        for(const auto &res: std::as_const(resources)) {
-          if(res.cacheId == cacheId) {
+        if(ResourceBucket *bucket = findBucket(cacheId)) {
+          for(const auto &res: std::as_const(bucket->resources)) {
             types[res.type] += 1;
           }
         }
@@ -896,15 +2417,16 @@ void Cache::editResources(QSharedPointer<Queue> queue,
           printf("Resource removal cancelled...\n\n");
           continue;
         } else if(types.contains(QString(typeInput.c_str()))) {
-          QMutableListIterator<Resource> it(resources);
+          QMutableVectorIterator<Resource> it(findBucket(cacheId)->resources);
           int removed = 0;
           while(it.hasNext()) {
             Resource res = it.next();
-            if(res.cacheId == cacheId && res.type == QString(typeInput.c_str())) {
+            if(res.type == QString(typeInput.c_str())) {
               it.remove();
               removed++;
             }
           }
+          pruneBucket(cacheId);
           printf("<<< Removed %d resource(s) connected to rom of type '\033[1;32m%s\033[0m'\n\n", removed, typeInput.c_str());
         } else {
           printf("No resources of type '\033[1;32m%s\033[0m' found, cancelling...\n\n", typeInput.c_str());
@@ -941,37 +2463,131 @@ bool Cache::purgeResources(QString purgeStr)
     }
   }
 
-  int purged = 0;
-
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
-    Resource res = it.next();
-    bool remove = false;
-    if(!module.isEmpty() && !type.isEmpty()) {
-      if(res.source == module && res.type == type) {
-        remove = true;
-      }
-    } else {
-      if(res.source == module || res.type == type) {
-        remove = true;
+  // Compare ids rather than strings. -2 stands for not given and matches nothing
+  const int moduleId = module.isEmpty() ? -2 : sourceId(module);
+  const int purgeTypeId = type.isEmpty() ? -2 : typeId(type);
+  if(moduleId == -1) {
+    printf("\033[1;31mNo resources from module '%s' found in the cache, please check the "
+           "spelling. Nothing was purged.\033[0m\n", module.toStdString().c_str());
+    return false;
+  }
+  if(purgeTypeId == -1) {
+    printf("\033[1;31mUnknown resource type '%s', please check '--cache help' for the valid "
+           "types. Nothing was purged.\033[0m\n", type.toStdString().c_str());
+    return false;
+  }
+  QHash<QString, QVector<int> > doomed;
+  for(auto it = resources.cbegin(); it != resources.cend(); ++it) {
+    const QVector<Resource> &bucketResources = it.value().resources;
+    for(int a = 0; a < bucketResources.size(); ++a) {
+      const Resource &res = bucketResources.at(a);
+      bool remove = false;
+      if(!module.isEmpty() && !type.isEmpty()) {
+        remove = res.sourceId == moduleId && res.typeId == purgeTypeId;
+      } else {
+        remove = res.sourceId == moduleId || res.typeId == purgeTypeId;
       }
+      if(remove) {
+        doomed[it.key()].append(a);
+      }
+    }
+  }
+  int purged = removeListed(doomed);
+  printf("Successfully purged %d resources from the cache.\n", purged);
+  int collected = collectBlobs();
+  if(collected > 0) {
+    printf("Removed %d media blobs no longer in use.\n", collected);
+  }
+  return true;
+}
+
+// Removes the listed resources (cacheId -> indexes into its bucket) and their media
+// files. Resources whose media file couldn't be removed are kept
+int Cache::removeListed(const QHash<QString, QVector<int> > &doomed, const int verbosity)
+{
+  QStringList mediaFiles;
+  for(auto it = doomed.cbegin(); it != doomed.cend(); ++it) {
+    const QVector<Resource> &bucketResources = resources.value(it.key()).resources;
+    for(const auto idx: std::as_const(it.value())) {
+      if(isMedia(bucketResources.at(idx).typeId)) {
+        mediaFiles.append(cacheDir.absolutePath() + "/" + bucketResources.at(idx).value);
+      }
+    }
+  }
+  const QSet<QString> failedFiles = removeMediaFiles(mediaFiles);
+
+  int removed = 0;
+  for(auto it = doomed.cbegin(); it != doomed.cend(); ++it) {
+    ResourceBucket *bucket = findBucket(it.key());
+    if(!bucket) {
+      continue;
     }
-    if(remove) {
-      if(res.type == "cover" || res.type == "screenshot" ||
-         res.type == "wheel" || res.type == "marquee" ||
-         res.type == "texture" || res.type == "video" ||
-         res.type == "manual") {
-        if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
+    QVector<int> indexes = it.value();
+    std::sort(indexes.begin(), indexes.end());
+    // Back to front, so the remaining indexes stay valid
+    for(int a = indexes.size() - 1; a >= 0; --a) {
+      const Resource &res = bucket->resources.at(indexes.at(a));
+      if(isMedia(res.typeId)) {
+        QString fileName = cacheDir.absolutePath() + "/" + res.value;
+        if(failedFiles.contains(fileName)) {
           printf("Couldn't purge media file '%s', skipping...\n", res.value.toStdString().c_str());
           continue;
         }
+        manifestRemove(fileName);
       }
-      it.remove();
-      purged++;
+      if(verbosity > 1)
+        printf("Purged resource for '%s' with value '%s'...\n", res.cacheId.toStdString().c_str(),
+               res.value.toStdString().c_str());
+      bucket->resources.remove(indexes.at(a));
+      removed++;
     }
+    pruneBucket(it.key());
   }
-  printf("Successfully purged %d resources from the cache.\n", purged);
-  return true;
+  return removed;
+}
+
+// Deletes the files on a small pool of I/O threads while printing a dot for every
+// tenth of them. Returns the files that couldn't be removed
+QSet<QString> Cache::removeMediaFiles(const QStringList &fileNames)
+{
+  QSet<QString> failedFiles;
+  if(fileNames.isEmpty()) {
+    return failedFiles;
+  }
+  QThreadPool ioPool;
+  ioPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), IOTHREADSMAX));
+  const int slices = qMin(ioPool.maxThreadCount(), fileNames.size());
+  const int sliceSize = (fileNames.size() + slices - 1) / slices;
+
+  // Whichever thread removes the file that completes a tenth prints its dot, so there is
+  // nothing to poll and exactly ten dots are printed
+  const qint64 total = fileNames.size();
+  QAtomicInt done = 0;
+  QList<QFuture<QStringList> > futures;
+  for(int start = 0; start < fileNames.size(); start += sliceSize) {
+    const QStringList slice = fileNames.mid(start, sliceSize);
+    futures.append(QtConcurrent::run(&ioPool, [slice, total, &done]() {
+      QStringList failed;
+      for(const auto &fileName: slice) {
+        if(!QFile::remove(fileName)) {
+          failed.append(fileName);
+        }
+        const qint64 removed = done.fetchAndAddRelaxed(1) + 1;
+        if(removed * 10 / total > (removed - 1) * 10 / total) {
+          printf("."); fflush(stdout);
+        }
+      }
+      return failed;
+    }));
+  }
+  ioPool.waitForDone();
+  for(auto &future: futures) {
+    const QStringList failed = future.result();
+    for(const auto &fileName: failed) {
+      failedFiles.insert(fileName);
+    }
+  }
+  return failedFiles;
 }
 
 bool Cache::purgeAll(const bool unattend)
@@ -989,36 +2605,24 @@ bool Cache::purgeAll(const bool unattend)
 
   printf("Purging ALL resources for the selected platform, please wait..."); fflush(stdout);
 
-  int purged = 0;
-  int dots = 0;
-  // Always make dotMod at least 1 or it will give "floating point exception" when modulo
-  int dotMod = resources.size() * 0.1 + 1;
-
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
-    if(dots % dotMod == 0) {
-      printf("."); fflush(stdout);
+  QHash<QString, QVector<int> > doomed;
+  for(auto it = resources.cbegin(); it != resources.cend(); ++it) {
+    QVector<int> &indexes = doomed[it.key()];
+    for(int a = 0; a < it.value().resources.size(); ++a) {
+      indexes.append(a);
     }
-    dots++;
-    Resource res = it.next();
-    if(res.type == "cover" || res.type == "screenshot" ||
-       res.type == "wheel" || res.type == "marquee" ||
-       res.type == "texture" || res.type == "video" ||
-       res.type == "manual") {
-      if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
-        printf("Couldn't purge media file '%s', skipping...\n", res.value.toStdString().c_str());
-        continue;
-      }
-    }
-    it.remove();
-    purged++;
   }
+  int purged = removeListed(doomed);
   printf("\033[1;32m Done!\033[0m\n");
   if(purged == 0) {
     printf("No resources for the current platform found in the resource cache.\n");
     return false;
   } else {
     printf("Successfully purged %d resources from the resource cache.\n", purged);
+    int collected = collectBlobs();
+    if(collected > 0) {
+      printf("Removed %d media blobs no longer in use.\n", collected);
+    }
   }
   printf("\n");
   return true;
@@ -1048,6 +2652,7 @@ QList<QFileInfo> Cache::getFileInfos(const QString &inputFolder, const QString &
 
 QStringList Cache::getCacheIdList(const QList<QFileInfo> &fileInfos)
 {
+  hashMissingQuickIds(fileInfos);
   QStringList cacheIdList;
   int dots = 0;
   // Always make dotMod at least 1 or it will give "floating point exception" when modulo
@@ -1267,8 +2872,17 @@ void Cache::assembleReport(const Settings &config, const QString filter)
     return;
   }
 
+  // Every report is answered from the types each file has, so each rom is only looked up once
+  QVector<quint64> fileTypes;
+  fileTypes.reserve(cacheIdList.size());
+  for(const auto &cacheId: std::as_const(cacheIdList)) {
+    fileTypes.append(typeMask(cacheId));
+  }
+
   QString dateTime = QDateTime::currentDateTime().toString("yyyyMMdd");
   for(const auto &resType: std::as_const(resTypeList)) {
+    const int resTypeId = typeId(resType);
+    const quint64 resTypeBit = (resTypeId >= 0?Q_UINT64_C(1) << resTypeId:0);
     QFile reportFile(reportsDir.absolutePath() + "/report-" + config.platform + "-missing_" + resType + "-" + dateTime + ".txt");
     printf("Report filename: '\033[1;32m%s\033[0m'\nAssembling report, please wait...",
            reportFile.fileName().toStdString().c_str()); fflush(stdout);
@@ -1283,16 +2897,7 @@ void Cache::assembleReport(const Settings &config, const QString filter)
           printf("."); fflush(stdout);
         }
         dots++;
-        bool found = false;
-        for(const auto &res: std::as_const(resources)) {
-          if(res.cacheId == cacheIdList.at(a)) {
-            if(res.type == resType) {
-              found = true;
-              break;
-            }
-          }
-        }
-        if(!found) {
+        if(!(fileTypes.at(a) & resTypeBit)) {
           missing++;
           reportFile.write(fileInfos.at(a).absoluteFilePath().toUtf8() + "\n");
         }
@@ -1339,63 +2944,47 @@ bool Cache::vacuumResources(const QString inputFolder, const QString filter,
   QList<QFileInfo> fileInfos = getFileInfos(inputFolder, filter);
   // Clean the quick id's aswell
   QMap<QString, QPair<qint64, QString> > quickIdsCleaned;
+  QHash<QString, QString> quickIdKeysCleaned;
   for(const auto &info: std::as_const(fileInfos)) {
     QString filePath = info.absoluteFilePath();
     if(quickIds.contains(filePath)) {
       quickIdsCleaned[filePath] = quickIds[filePath];
+      if(quickIdKeys.contains(filePath)) {
+        quickIdKeysCleaned[filePath] = quickIdKeys[filePath];
+      }
     }
   }
   quickIds = quickIdsCleaned;
-  QStringList cacheIdList = getCacheIdList(fileInfos);
+  quickIdKeys = quickIdKeysCleaned;
+  const QStringList cacheIdList = getCacheIdList(fileInfos);
   if(cacheIdList.isEmpty()) {
     printf("No cache id's found, something is wrong, cancelling...\n");
     return false;
   }
+  const QSet<QString> romCacheIds(cacheIdList.cbegin(), cacheIdList.cend());
 
-  int vacuumed = 0;
-  {
-    int dots = 0;
-    // Always make dotMod at least 1 or it will give "floating point exception" when modulo
-    int dotMod = resources.size() * 0.1 + 1;
-
-    QMutableListIterator<Resource> it(resources);
-    while(it.hasNext()) {
-      if(dots % dotMod == 0) {
-        printf("."); fflush(stdout);
-      }
-      dots++;
-      Resource res = it.next();
-      bool remove = true;
-      for(const auto &cacheId: std::as_const(cacheIdList)) {
-        if(res.cacheId == cacheId) {
-          remove = false;
-          break;
-        }
-      }
-      if(remove) {
-        if(res.type == "cover" || res.type == "screenshot" ||
-           res.type == "wheel" || res.type == "marquee" ||
-           res.type == "texture" || res.type == "video" ||
-           res.type == "manual") {
-          if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
-            printf("Couldn't purge media file '%s', skipping...\n", res.value.toStdString().c_str());
-            continue;
-          }
-        }
-        if(verbosity > 1)
-          printf("Purged resource for '%s' with value '%s'...\n", res.cacheId.toStdString().c_str(),
-                 res.value.toStdString().c_str());
-        it.remove();
-        vacuumed++;
-      }
+  QHash<QString, QVector<int> > doomed;
+  for(auto it = resources.cbegin(); it != resources.cend(); ++it) {
+    // The whole bucket shares the cache id, so one lookup covers all of its resources
+    if(romCacheIds.contains(it.key())) {
+      continue;
+    }
+    QVector<int> &indexes = doomed[it.key()];
+    for(int a = 0; a < it.value().resources.size(); ++a) {
+      indexes.append(a);
     }
   }
+  int vacuumed = removeListed(doomed, verbosity);
   printf("\033[1;32m Done!\033[0m\n");
   if(vacuumed == 0) {
     printf("All resources match a file in your romset. No resources vacuumed.\n");
     return false;
   } else {
     printf("Successfully vacuumed %d resources from the resource cache.\n", vacuumed);
+    int collected = collectBlobs();
+    if(collected > 0) {
+      printf("Removed %d media blobs no longer in use.\n", collected);
+    }
   }
   printf("\n");
   return true;
@@ -1414,24 +3003,27 @@ bool Cache::detectScrapingErrors(const Settings &config)
 
   printf("Detecting possible scraping mistakes, this can take several minutes, please wait...\n");
 
-  const auto keys = quickIds.keys();
-  for(const auto &fileName: std::as_const(keys)) {
-    QString id =  quickIds[fileName].second;
-    for(const auto &res: std::as_const(resources)) {
-      if(res.cacheId == id && res.type == "title") {
-        filesTitleResources.insert(fileName, res);
-      }
+  for(auto it = quickIds.cbegin(); it != quickIds.cend(); ++it) {
+    ResourceBucket *bucket = findBucket(it.value().second);
+    if(!bucket) {
+      continue;
+    }
+    const auto titleIdxs = bucket->ofType(TITLE);
+    for(const auto idx: titleIdxs) {
+      filesTitleResources.insert(it.key(), bucket->resources.at(idx));
     }
   }
 
   // Loop on filesTitleResources to check key (filename) against title (res.value)
   // updating possibleErrors and possibleErrorsCount.
   NameTools *NameTool = new NameTools("cache");
+  // The helpers only depend on the scraper, so they are set up once rather than per title
+  QSharedPointer<NetManager> manager = QSharedPointer<NetManager>(new NetManager());
+  AbstractScraper helperScraper(&Skyscraper::config, manager, "cache", NameTool);
+  QHash<QString, QSharedPointer<ScraperWorker> > helperWorkers;
   const auto uniqueKeys = filesTitleResources.uniqueKeys();
   for(const auto &name: std::as_const(uniqueKeys)) {
     // Normalize name:
-    QSharedPointer<NetManager> manager = QSharedPointer<NetManager>(new NetManager());
-    AbstractScraper helperScraper(&Skyscraper::config, manager, "cache", NameTool);
     QString baseName = helperScraper.getCompareTitle(QFileInfo(name));
 
     // Compare against the title calculated for each scraper:
@@ -1446,11 +3038,15 @@ bool Cache::detectScrapingErrors(const Settings &config)
       GameEntry game;
       game.title = title.value;
       QList<GameEntry> gameEntries = { game };
-      Settings currentConfig = Skyscraper::config;
-      currentConfig.scraper = title.source;
-      ScraperWorker helperWorker(nullptr, nullptr, manager, currentConfig, "0");
-      game = helperWorker.getBestEntry(gameEntries, baseName, lowestDistance, stringSize);
-      int searchMatch = helperWorker.getSearchMatch(title.value, baseName, lowestDistance, stringSize);
+      QSharedPointer<ScraperWorker> &helperWorker = helperWorkers[title.source];
+      if(helperWorker.isNull()) {
+        Settings currentConfig = Skyscraper::config;
+        currentConfig.scraper = title.source;
+        helperWorker = QSharedPointer<ScraperWorker>(new ScraperWorker(nullptr, nullptr, manager,
+                                                                       currentConfig, "0"));
+      }
+      game = helperWorker->getBestEntry(gameEntries, baseName, lowestDistance, stringSize);
+      int searchMatch = helperWorker->getSearchMatch(title.value, baseName, lowestDistance, stringSize);
       if(config.verbosity >= 1) {
         qDebug() << "Assessment:" << title.value << "matches" << baseName << "with" << searchMatch << "%";
       }
@@ -1497,6 +3093,10 @@ bool Cache::detectScrapingErrors(const Settings &config)
 
 void Cache::showStats(int verbosity)
 {
+  if(lazyLoad) {
+    flushJournal();
+    readSqliteCounts();
+  }
   printf("Resource cache stats for selected platform:\n");
   if(verbosity == 1) {
     int ids = 0;
@@ -1618,62 +3218,62 @@ void Cache::showStats(int verbosity)
   printf("\n");
 }
 
-void Cache::addToResCounts(const QString source, const QString type)
+void Cache::addToResCounts(const QString source, const QString type, const int count)
 {
   if(type == "id") {
-    resCountsMap[source].ids++;
+    resCountsMap[source].ids += count;
   } else if(type == "title") {
-    resCountsMap[source].titles++;
+    resCountsMap[source].titles += count;
   } else if(type == "platform") {
-    resCountsMap[source].platforms++;
+    resCountsMap[source].platforms += count;
   } else if(type == "description") {
-    resCountsMap[source].descriptions++;
+    resCountsMap[source].descriptions += count;
   } else if(type == "publisher") {
-    resCountsMap[source].publishers++;
+    resCountsMap[source].publishers += count;
   } else if(type == "developer") {
-    resCountsMap[source].developers++;
+    resCountsMap[source].developers += count;
   } else if(type == "players") {
-    resCountsMap[source].players++;
+    resCountsMap[source].players += count;
   } else if(type == "ages") {
-    resCountsMap[source].ages++;
+    resCountsMap[source].ages += count;
   } else if(type == "tags") {
-    resCountsMap[source].tags++;
+    resCountsMap[source].tags += count;
   } else if(type == "franchises") {
-    resCountsMap[source].franchises++;
+    resCountsMap[source].franchises += count;
   } else if(type == "rating") {
-    resCountsMap[source].ratings++;
+    resCountsMap[source].ratings += count;
   } else if(type == "releasedate") {
-    resCountsMap[source].releaseDates++;
+    resCountsMap[source].releaseDates += count;
   } else if(type == "cover") {
-    resCountsMap[source].covers++;
+    resCountsMap[source].covers += count;
   } else if(type == "screenshot") {
-    resCountsMap[source].screenshots++;
+    resCountsMap[source].screenshots += count;
   } else if(type == "wheel") {
-    resCountsMap[source].wheels++;
+    resCountsMap[source].wheels += count;
   } else if(type == "marquee") {
-    resCountsMap[source].marquees++;
+    resCountsMap[source].marquees += count;
   } else if(type == "texture") {
-    resCountsMap[source].textures++;
+    resCountsMap[source].textures += count;
   } else if(type == "video") {
-    resCountsMap[source].videos++;
+    resCountsMap[source].videos += count;
   } else if(type == "manual") {
-    resCountsMap[source].manuals++;
+    resCountsMap[source].manuals += count;
   } else if(type == "guides") {
-    resCountsMap[source].guides++;
+    resCountsMap[source].guides += count;
   } else if(type == "cheats") {
-    resCountsMap[source].cheats++;
+    resCountsMap[source].cheats += count;
   } else if(type == "reviews") {
-    resCountsMap[source].reviews++;
+    resCountsMap[source].reviews += count;
   } else if(type == "artbooks") {
-    resCountsMap[source].artbooks++;
+    resCountsMap[source].artbooks += count;
   } else if(type == "vgmaps") {
-    resCountsMap[source].vgmaps++;
+    resCountsMap[source].vgmaps += count;
   } else if(type == "sprites") {
-    resCountsMap[source].sprites++;
+    resCountsMap[source].sprites += count;
   } else if(type == "trivia") {
-    resCountsMap[source].trivias++;
+    resCountsMap[source].trivias += count;
   } else if(type == "chiptuneid") {
-    resCountsMap[source].chiptunes++;
+    resCountsMap[source].chiptunes += count;
   }
 }
 
@@ -1704,6 +3304,12 @@ void Cache::readPriorities()
       continue;
     }
     QString type = orderElem.attribute("type");
+    const int typeIdx = typeId(type);
+    if(typeIdx == -1) {
+      printf("Unknown type '%s' in priorities.xml, skipping...\n", type.toStdString().c_str());
+      errors++;
+      continue;
+    }
     QStringList sources;
     // ALWAYS prioritize 'user' resources highest (added with edit mode)
     sources.append("user");
@@ -1717,7 +3323,14 @@ void Cache::readPriorities()
     for(int b = 0; b < sourceNodes.length(); ++b) {
       sources.append(sourceNodes.at(b).toElement().text());
     }
-    prioMap[type] = sources;
+    // Rank each source once here, so fillBlanks() doesn't have to walk the lists per game
+    QHash<QString, int> &ranks = prioRanks[typeIdx];
+    ranks.clear();
+    for(int b = 0; b < sources.size(); ++b) {
+      if(!ranks.contains(sources.at(b))) {
+        ranks.insert(sources.at(b), b);
+      }
+    }
   }
   printf("Priorities loaded successfully");
   if(errors != 0) {
@@ -1726,9 +3339,23 @@ void Cache::readPriorities()
   printf("!\n\n");
 }
 
-bool Cache::write(const bool onlyQuickId)
+bool Cache::write(const bool onlyQuickId, const QString &format)
 {
-  QMutexLocker locker(&cacheMutex);
+  flushJournal();
+  CacheLocker locker(cacheLock, lockCount, lockWaits, true);
+  writeManifest();
+
+  if(subsetLoad) {
+    // Writing the partly loaded cache back would lose every resource that wasn't loaded
+    printf("Only the resources of the queued roms were loaded, changes are kept in the cache "
+           "journal and folded into the cache on the next full run.\n\n");
+    return true;
+  }
+
+  QString targetFormat = format.isEmpty()?Skyscraper::config.cacheFormat:format;
+  if(targetFormat == "sqlite") {
+    return writeSqlite(onlyQuickId);
+  }
 
   QFile quickIdFile(cacheDir.absolutePath() + "/quickid.xml.tmp");
   QString quickIdFileOrig = cacheDir.absolutePath() + "/quickid.xml";
@@ -1744,6 +3371,9 @@ bool Cache::write(const bool onlyQuickId)
       xml.writeAttribute("filepath", key);
       xml.writeAttribute("timestamp", QString::number(quickIds[key].first));
       xml.writeAttribute("id", quickIds[key].second);
+      if(quickIdKeys.contains(key)) {
+        xml.writeAttribute("filekey", quickIdKeys.value(key));
+      }
       xml.writeEndElement();
     }
     xml.writeEndElement();
@@ -1760,95 +3390,285 @@ bool Cache::write(const bool onlyQuickId)
     }
   }
 
+  // A partly loaded sharded cache can only be written back as shards
+  if(targetFormat != "sqlite" && (Skyscraper::config.cacheShards || partialShards)) {
+    int total = resourceCount();
+    printf("Writing %d (%d new) resources to cache shards, please wait... ",
+           total, total - resAtLoad); fflush(stdout);
+    if(!writeShards(targetFormat)) {
+      printf("\033[1;31mFailed!\033[0m\nCouldn't write the cache shards in '%s', the shards "
+             "not yet written were left untouched.\n\n",
+             (cacheDir.absolutePath() + "/shards").toStdString().c_str());
+      return false;
+    }
+    printf("\033[1;32mDone!\033[0m\n\n");
+    moveOtherFormatsAside(targetFormat, true);
+    resetJournal();
+    return true;
+  }
+
+  bool binary = targetFormat == "binary";
   bool result = false;
-  QFile cacheFile(cacheDir.absolutePath() + "/db.xml.tmp");
-  QString cacheFileOrig = cacheDir.absolutePath() + "/db.xml";
+  QString cacheFileOrig = cacheFileName(targetFormat);
+  QFile cacheFile(cacheFileOrig + ".tmp");
   if(cacheFile.open(QIODevice::WriteOnly)) {
+    int total = resourceCount();
     printf("Writing %d (%d new) resources to cache, please wait... ",
-           resources.length(), resources.length() - resAtLoad); fflush(stdout);
-    QXmlStreamWriter xml(&cacheFile);
-    xml.setAutoFormatting(true);
-    xml.writeStartDocument();
-    xml.writeStartElement("resources");
-    for(const auto &resource: std::as_const(resources)) {
-      xml.writeStartElement("resource");
-      xml.writeAttribute("id", resource.cacheId);
-      xml.writeAttribute("type", resource.type);
-      xml.writeAttribute("source", resource.source);
-      xml.writeAttribute("timestamp", QString::number(resource.timestamp));
-      xml.writeCharacters(resource.value);
-      xml.writeEndElement();
+           total, total - resAtLoad); fflush(stdout);
+    // Sort the ids so the file doesn't get reshuffled by the hash order on every write
+    QStringList cacheIds = resources.keys();
+    cacheIds.sort();
+    if(binary) {
+      result = writeBinary(cacheFile, cacheIds);
+    } else {
+      result = writeXml(cacheFile, cacheIds);
     }
-    xml.writeEndElement();
-    xml.writeEndDocument();
-    result = true;
-    printf("\033[1;32mDone!\033[0m\n\n");
     cacheFile.close();
+    if(!result) {
+      printf("\033[1;31mFailed!\033[0m\nCouldn't write '%s', the existing cache was left untouched.\n\n",
+             cacheFile.fileName().toStdString().c_str());
+      cacheFile.remove();
+      return false;
+    }
+    printf("\033[1;32mDone!\033[0m\n\n");
     if(QFile::exists(cacheFileOrig + ".bak")) {
       QFile::remove(cacheFileOrig + ".bak");
     }
     QFile::rename(cacheFileOrig, cacheFileOrig + ".bak");
     QFile::rename(cacheFileOrig + ".tmp", cacheFileOrig);
+    moveOtherFormatsAside(targetFormat);
+    resetJournal();
   }
   return result;
 }
 
-// This verifies all attached media files and deletes those that have no entry in the cache
-void Cache::validate()
+bool Cache::writeSqlite(const bool onlyQuickId)
 {
-  printf("Starting resource cache validation run, please wait...\n");
-  
-  if(!QFileInfo::exists(cacheDir.absolutePath() + "/db.xml")) {
-    printf("'db.xml' not found, cache cleaning cancelled...\n");
-    return;
+  if(lazyLoad) {
+    printf("All changes have already been saved to the cache database.\n\n");
+    return true;
   }
+  QSqlDatabase db = database();
+  if(!db.isOpen()) {
+    return false;
+  }
+  int total = resourceCount();
+  if(onlyQuickId) {
+    printf("Writing quick ids to cache database, please wait... "); fflush(stdout);
+  } else {
+    printf("Writing %d (%d new) resources to cache database, please wait... ",
+           total, total - resAtLoad); fflush(stdout);
+  }
+  db.transaction();
+  QSqlQuery query(db);
+  bool ok = query.exec("DELETE FROM quickids");
+  query.prepare("INSERT INTO quickids (filepath, timestamp, cacheid, filekey)"
+                " VALUES (:filepath, :timestamp, :cacheid, :filekey)");
+  for(auto it = quickIds.cbegin(); ok && it != quickIds.cend(); ++it) {
+    query.bindValue(":filepath", it.key());
+    query.bindValue(":timestamp", it.value().first);
+    query.bindValue(":cacheid", it.value().second);
+    query.bindValue(":filekey", quickIdKeys.value(it.key()));
+    ok = query.exec();
+  }
+  if(ok && !onlyQuickId) {
+    ok = query.exec("DELETE FROM resources");
+    query.prepare("INSERT INTO resources (cacheid, type, source, timestamp, value)"
+                  " VALUES (:cacheid, :type, :source, :timestamp, :value)");
+    for(auto bucketIt = resources.cbegin(); ok && bucketIt != resources.cend(); ++bucketIt) {
+      for(const auto &resource: bucketIt.value().resources) {
+        query.bindValue(":cacheid", resource.cacheId);
+        query.bindValue(":type", resource.type);
+        query.bindValue(":source", resource.source);
+        query.bindValue(":timestamp", resource.timestamp);
+        query.bindValue(":value", resource.text());
+        ok = query.exec();
+        if(!ok) {
+          break;
+        }
+      }
+    }
+  }
+  if(ok) {
+    ok = db.commit();
+  }
+  if(!ok) {
+    qDebug() << query.lastError();
+    db.rollback();
+    printf("\033[1;31mFailed!\033[0m\nCouldn't write the cache database, it was left untouched.\n\n");
+    return false;
+  }
+  printf("\033[1;32mDone!\033[0m\n\n");
+  if(!onlyQuickId) {
+    moveOtherFormatsAside("sqlite");
+    resetJournal();
+  }
+  return true;
+}
 
-  QDir coversDir(cacheDir.absolutePath() + "/covers", "*.*", QDir::Name, QDir::Files);
-  QDir screenshotsDir(cacheDir.absolutePath() + "/screenshots", "*.*", QDir::Name, QDir::Files);
-  QDir wheelsDir(cacheDir.absolutePath() + "/wheels", "*.*", QDir::Name, QDir::Files);
-  QDir marqueesDir(cacheDir.absolutePath() + "/marquees", "*.*", QDir::Name, QDir::Files);
-  QDir texturesDir(cacheDir.absolutePath() + "/textures", "*.*", QDir::Name, QDir::Files);
-  QDir videosDir(cacheDir.absolutePath() + "/videos", "*.*", QDir::Name, QDir::Files);
-  QDir manualsDir(cacheDir.absolutePath() + "/manuals", "*.*", QDir::Name, QDir::Files);
-
-  QDirIterator coversDirIt(coversDir.absolutePath(),
-                           QDir::Files | QDir::NoDotAndDotDot,
-                           QDirIterator::Subdirectories);
-
-  QDirIterator screenshotsDirIt(screenshotsDir.absolutePath(),
-                                QDir::Files | QDir::NoDotAndDotDot,
-                                QDirIterator::Subdirectories);
+// Once the cache is saved in one format the others are stale, so they are moved
+// aside to make sure they can never be loaded instead
+void Cache::moveOtherFormatsAside(const QString &format, const bool sharded)
+{
+  const QStringList formats = {"xml", "binary", "sqlite"};
+  for(const auto &otherFormat: formats) {
+    if(sharded && otherFormat != format) {
+      const QStringList sources = shardSources(otherFormat);
+      for(const auto &source: sources) {
+        QFile::remove(shardFileName(otherFormat, source) + ".idx");
+        QFile::remove(shardFileName(otherFormat, source) + ".bak");
+        QFile::rename(shardFileName(otherFormat, source), shardFileName(otherFormat, source) + ".bak");
+      }
+    }
+    QString otherFile = cacheFileName(otherFormat);
+    if((otherFormat == format && !sharded) || !QFile::exists(otherFile)) {
+      continue;
+    }
+    if(otherFormat == "sqlite") {
+      // Closing the last connection checkpoints the WAL back into the database file
+      closeDatabase();
+      sqliteBacked = false;
+      QFile::remove(otherFile + "-wal");
+      QFile::remove(otherFile + "-shm");
+    }
+    QFile::remove(otherFile + ".bak");
+    QFile::rename(otherFile, otherFile + ".bak");
+  }
+  if(!sharded && QFileInfo::exists(cacheDir.absolutePath() + "/shards")) {
+    // Everything is in the one file now
+    QDir(cacheDir.absolutePath() + "/shards.bak").removeRecursively();
+    cacheDir.rename("shards", "shards.bak");
+  }
+}
 
-  QDirIterator wheelsDirIt(wheelsDir.absolutePath(),
-                           QDir::Files | QDir::NoDotAndDotDot,
-                           QDirIterator::Subdirectories);
+bool Cache::writeXml(QFile &cacheFile, const QStringList &cacheIds, const int onlySource)
+{
+  QXmlStreamWriter xml(&cacheFile);
+  xml.setAutoFormatting(true);
+  xml.writeStartDocument();
+  xml.writeStartElement("resources");
+  for(const auto &cacheId: std::as_const(cacheIds)) {
+    const auto &bucketResources = resources[cacheId].resources;
+    for(const auto &resource: bucketResources) {
+      if(onlySource != -1 && resource.sourceId != onlySource) {
+        continue;
+      }
+      xml.writeStartElement("resource");
+      xml.writeAttribute("id", resource.cacheId);
+      xml.writeAttribute("type", resource.type);
+      xml.writeAttribute("source", resource.source);
+      xml.writeAttribute("timestamp", QString::number(resource.timestamp));
+      xml.writeCharacters(resource.text());
+      xml.writeEndElement();
+    }
+  }
+  xml.writeEndElement();
+  xml.writeEndDocument();
+  return !xml.hasError();
+}
 
-  QDirIterator marqueesDirIt(marqueesDir.absolutePath(),
-                             QDir::Files | QDir::NoDotAndDotDot,
-                             QDirIterator::Subdirectories);
+bool Cache::writeBinary(QFile &cacheFile, const QStringList &cacheIds, const int onlySource)
+{
+  QHash<QString, quint32> stringIdxs;
+  QStringList strings;
+  auto intern = [&](const QString &string) {
+    if(!stringIdxs.contains(string)) {
+      stringIdxs.insert(string, strings.size());
+      strings.append(string);
+    }
+  };
+  quint32 resCount = 0;
+  for(const auto &cacheId: std::as_const(cacheIds)) {
+    const auto &bucketResources = resources[cacheId].resources;
+    for(const auto &resource: bucketResources) {
+      if(onlySource != -1 && resource.sourceId != onlySource) {
+        continue;
+      }
+      intern(resource.cacheId);
+      intern(resource.type);
+      intern(resource.source);
+      resCount++;
+    }
+  }
 
-  QDirIterator texturesDirIt(texturesDir.absolutePath(),
-                             QDir::Files | QDir::NoDotAndDotDot,
-                             QDirIterator::Subdirectories);
+  QDataStream out(&cacheFile);
+  out.setByteOrder(QDataStream::LittleEndian);
+  auto writeString = [&](const QString &string) {
+    QByteArray utf8 = string.toUtf8();
+    out << (quint32)utf8.size();
+    out.writeRawData(utf8.constData(), utf8.size());
+  };
+  out << BINMAGIC << BINVERSION << (quint32)strings.size();
+  for(const auto &string: std::as_const(strings)) {
+    writeString(string);
+  }
+  out << resCount;
+  for(const auto &cacheId: std::as_const(cacheIds)) {
+    const auto &bucketResources = resources[cacheId].resources;
+    for(const auto &resource: bucketResources) {
+      if(onlySource != -1 && resource.sourceId != onlySource) {
+        continue;
+      }
+      out << stringIdxs.value(resource.cacheId)
+          << stringIdxs.value(resource.type)
+          << stringIdxs.value(resource.source)
+          << resource.timestamp;
+      if(resource.packed.isEmpty()) {
+        writeString(resource.value);
+      } else {
+        out << (quint32(resource.packed.size()) | BINPACKED);
+        out.writeRawData(resource.packed.constData(), resource.packed.size());
+      }
+    }
+  }
+  return out.status() == QDataStream::Ok;
+}
 
-  QDirIterator videosDirIt(videosDir.absolutePath(),
-                           QDir::Files | QDir::NoDotAndDotDot,
-                           QDirIterator::Subdirectories);
+// This verifies all attached media files and deletes those that have no entry in the cache
+void Cache::validate()
+{
+  printf("Starting resource cache validation run, please wait...\n");
+  
+  if(!hasCacheFile("xml") && !hasCacheFile("binary") && !hasCacheFile("sqlite")) {
+    printf("No resource cache database found, cache cleaning cancelled...\n");
+    return;
+  }
 
-  QDirIterator manualsDirIt(manualsDir.absolutePath(),
-                           QDir::Files | QDir::NoDotAndDotDot,
-                           QDirIterator::Subdirectories);
+  // Findings are written to the report as they are made, so a long run can be followed
+  // and nothing is lost if it's interrupted
+  QDir reportsDir(QDir::currentPath() + "/reports");
+  if(reportsDir.exists() || reportsDir.mkpath(".")) {
+    QString dateTime = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    validateReport.setFileName(reportsDir.absolutePath() + "/report-" + Skyscraper::config.platform +
+                               "-validate-" + dateTime + ".txt");
+    if(validateReport.open(QIODevice::WriteOnly)) {
+      printf("Report filename: '\033[1;32m%s\033[0m'\n", validateReport.fileName().toStdString().c_str());
+    }
+  }
+  if(!validateReport.isOpen()) {
+    printf("Couldn't create the validation report in '%s', findings are only shown here.\n",
+           reportsDir.absolutePath().toStdString().c_str());
+  }
+  readChecksums();
 
+  // The media folders don't share any files, so they are all checked at the same time
+  const QStringList mediaTypes = { "cover", "screenshot", "wheel", "marquee",
+                                   "texture", "video", "manual" };
+  QList<QFuture<QPair<int, int> > > futures;
+  for(const auto &mediaType: mediaTypes) {
+    futures.append(QtConcurrent::run([this, mediaType]() {
+      int deleted = 0;
+      int noDelete = 0;
+      verifyFiles(cacheDir.absolutePath() + "/" + mediaType + "s", mediaType, deleted, noDelete);
+      return qMakePair(deleted, noDelete);
+    }));
+  }
   int filesDeleted = 0;
   int filesNoDelete = 0;
-
-  verifyFiles(coversDirIt, filesDeleted, filesNoDelete, "cover");
-  verifyFiles(screenshotsDirIt, filesDeleted, filesNoDelete, "screenshot");
-  verifyFiles(wheelsDirIt, filesDeleted, filesNoDelete, "wheel");
-  verifyFiles(marqueesDirIt, filesDeleted, filesNoDelete, "marquee");
-  verifyFiles(texturesDirIt, filesDeleted, filesNoDelete, "texture");
-  verifyFiles(videosDirIt, filesDeleted, filesNoDelete, "video");
-  verifyFiles(manualsDirIt, filesDeleted, filesNoDelete, "manual");
+  for(auto &future: futures) {
+    filesDeleted += future.result().first;
+    filesNoDelete += future.result().second;
+  }
 
   if(filesDeleted == 0 && filesNoDelete == 0) {
     printf("No inconsistencies found between cached files and the database. :)\n\n");
@@ -1867,314 +3687,908 @@ void Cache::validate()
   } else {
     printf("Successfully deleted %d inconsistent resources.\n", resourcesDeleted);
   }
+
+  if(Skyscraper::config.cacheDedup) {
+    printf("Deduplicating cached media files, please wait... "); fflush(stdout);
+    for(const auto &bucket: std::as_const(resources)) {
+      for(const auto &res: bucket.resources) {
+        if(isMedia(res.typeId)) {
+          dedupMedia(cacheDir.absolutePath() + "/" + res.value);
+          manifestAdd(cacheDir.absolutePath() + "/" + res.value);
+        }
+      }
+    }
+    printf("\033[1;32mDone!\033[0m\n");
+  }
+  int collected = collectBlobs();
+  if(collected > 0) {
+    printf("Removed %d media blobs no longer in use.\n\n", collected);
+  }
+  writeChecksums();
+  validateReport.close();
 }
 
 void Cache::verifyResources(int &resourcesDeleted)
 {
-  NameTools *NameTool = new NameTools("cache");
+  // Reverse the quick ids once rather than searching them for every canonical resource
+  QHash<QString, QString> romFiles;
+  for(auto it = quickIds.cbegin(); it != quickIds.cend(); ++it) {
+    if(!romFiles.contains(it.value().second)) {
+      romFiles.insert(it.value().second, it.key());
+    }
+  }
 
-  QString lastFileChecksumed;
-  CanonicalData lastCanonicalData;
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
-    bool remove = false;
-    Resource res = it.next();
-    if(res.version != 1) {
-      printf("Cache entry has an incompatible version, ignoring;\"%d\";\"%s\";\"%s\";\"%s\";\"%s\"\n",
-             res.version,
-             res.cacheId.toStdString().c_str(),
-             res.source.toStdString().c_str(),
-             res.type.toStdString().c_str(),
-             res.value.toStdString().c_str());
-    } else if(res.type.isEmpty() || res.source.isEmpty() || res.cacheId.isEmpty()) {
-      // I don't care about the timestamp
-      printf("Cache entry is missing the 'type', 'resource' or 'cacheId', deleting;\n");
-      remove = true;
-    } else if(res.type == "completed" || res.type == "favourite" || res.type == "played") {
-      if(res.value != "true" && res.value != "false") {
-        printf("Incorrect boolean value;\"%s\"\n", res.value.toStdString().c_str());
-        remove = true;
+  // Every bucket is checked on its own, so they are split evenly between the threads.
+  // The buckets are looked up here, the threads never touch the hash itself
+  QList<QPair<QString, ResourceBucket *> > buckets;
+  const auto cacheIds = resources.keys();
+  for(const auto &cacheId: std::as_const(cacheIds)) {
+    buckets.append(qMakePair(cacheId, findBucket(cacheId)));
+  }
+  const int slices = qMax(1, qMin(QThread::idealThreadCount(), buckets.size()));
+  const int sliceSize = (buckets.size() + slices - 1) / slices;
+  QList<QFuture<int> > futures;
+  for(int start = 0; start < buckets.size(); start += sliceSize) {
+    const auto slice = buckets.mid(start, sliceSize);
+    futures.append(QtConcurrent::run([this, slice, &romFiles]() {
+      NameTools *NameTool = new NameTools("cache");
+      int deleted = 0;
+      for(const auto &bucket: slice) {
+        const QString romFile = romFiles.value(bucket.first);
+        QString findings;
+        QMutableVectorIterator<Resource> it(bucket.second->resources);
+        while(it.hasNext()) {
+          Resource res = it.next();
+          bool changed = false;
+          bool remove = verifyResource(res, changed, romFile, NameTool, findings);
+          if(remove) {
+            findings.append(QString::asprintf("Deleting inconsistent resource;\"%s\";\"%s\";\"%s\";\"%s\"\n",
+                                              res.cacheId.toStdString().c_str(),
+                                              res.source.toStdString().c_str(),
+                                              res.type.toStdString().c_str(),
+                                              res.text().toStdString().c_str()));
+            if(!Skyscraper::config.pretend) {
+              it.remove();
+            }
+            deleted++;
+          } else if(changed) {
+            it.setValue(res);
+          }
+        }
+        reportFindings(findings);
       }
-    } else if(res.type == "title"  || res.type == "platform"  || res.type == "description" ||
-              res.type == "trivia" || res.type == "publisher" || res.type == "developer"   ||
-              res.type == "guides" || res.type == "vgmaps"    || res.type == "chiptuneid"  ||
-              res.type == "chiptunepath"  || res.type == "canonicalname"    ||
-              res.type == "canonicalfile" || res.type == "canonicalcatalog" ||
-              res.type == "canonicalmameid" || res.type == "sprites" || res.type == "id" ||
-              res.type == "cheats" || res.type == "artbooks"  || res.type == "reviews" ||
-              (Skyscraper::config.skipChecksum && (res.type == "canonicalcrc" ||
-                res.type == "canonicalmd5" || res.type == "canonicalsha1"))) {
-      if(res.value.isEmpty()) {
-        printf("Empty resource detected;\n");
+      delete NameTool;
+      return deleted;
+    }));
+  }
+  for(auto &future: futures) {
+    resourcesDeleted += future.result();
+  }
+  for(const auto &bucket: std::as_const(buckets)) {
+    pruneBucket(bucket.first);
+  }
+}
+
+// Checks a single resource, appending anything worth reporting to 'findings'. Returns
+// true if the resource should be deleted and sets 'changed' if its value was corrected
+bool Cache::verifyResource(Resource &res, bool &changed, const QString &romFile,
+                           NameTools *NameTool, QString &findings)
+{
+  bool remove = false;
+  if(res.version != 1) {
+    findings.append(QString::asprintf("Cache entry has an incompatible version, ignoring;\"%d\";\"%s\";\"%s\";\"%s\";\"%s\"\n",
+                                      res.version,
+                                      res.cacheId.toStdString().c_str(),
+                                      res.source.toStdString().c_str(),
+                                      res.type.toStdString().c_str(),
+                                      res.text().toStdString().c_str()));
+  } else if(res.type.isEmpty() || res.source.isEmpty() || res.cacheId.isEmpty()) {
+    // I don't care about the timestamp
+    findings.append("Cache entry is missing the 'type', 'resource' or 'cacheId', deleting;\n");
+    remove = true;
+  } else if(res.type == "completed" || res.type == "favourite" || res.type == "played") {
+    if(res.value != "true" && res.value != "false") {
+      findings.append(QString::asprintf("Incorrect boolean value;\"%s\"\n", res.value.toStdString().c_str()));
+      remove = true;
+    }
+  } else if(res.type == "title"  || res.type == "platform"  || res.type == "description" ||
+            res.type == "trivia" || res.type == "publisher" || res.type == "developer"   ||
+            res.type == "guides" || res.type == "vgmaps"    || res.type == "chiptuneid"  ||
+            res.type == "chiptunepath"  || res.type == "canonicalname"    ||
+            res.type == "canonicalfile" || res.type == "canonicalcatalog" ||
+            res.type == "canonicalmameid" || res.type == "sprites" || res.type == "id" ||
+            res.type == "cheats" || res.type == "artbooks"  || res.type == "reviews" ||
+            (Skyscraper::config.skipChecksum && (res.type == "canonicalcrc" ||
+              res.type == "canonicalmd5" || res.type == "canonicalsha1"))) {
+    // Long texts are kept compressed in 'packed' and have no 'value' then
+    if(res.value.isEmpty() && res.packed.isEmpty()) {
+      findings.append("Empty resource detected;\n");
+      remove = true;
+    }
+  } else if(res.type == "releasedate") {
+    QString oldValue = res.value;
+    res.value = StrTools::conformReleaseDate(res.value);
+    if(res.value.isEmpty()) {
+      findings.append(QString::asprintf("Date is not valid;\"%s\"\n", oldValue.toStdString().c_str()));
+      remove = true;
+    } else if(oldValue != res.value && !Skyscraper::config.pretend) {
+      findings.append(QString::asprintf("Date was not conformant, corrected;\"%s\";\"%s\"\n",
+                                        oldValue.toStdString().c_str(), res.value.toStdString().c_str()));
+      changed = true;
+    }
+  } else if(res.type == "ages") {
+    QString oldValue = res.value;
+    res.value = StrTools::conformAges(res.value);
+    if(res.value.isEmpty()) {
+      findings.append(QString::asprintf("Age rating is not valid;\"%s\"\n", oldValue.toStdString().c_str()));
+      remove = true;
+    } else if(oldValue != res.value && !Skyscraper::config.pretend) {
+      findings.append(QString::asprintf("Ages was not conformant, corrected;\"%s\";\"%s\"\n",
+                                        oldValue.toStdString().c_str(), res.value.toStdString().c_str()));
+      changed = true;
+    }
+  } else if(res.type == "tags" || res.type == "franchises") {
+    QString oldValue = res.value;
+    res.value = StrTools::conformTags(res.value);
+    if(res.value.isEmpty()) {
+      findings.append(QString::asprintf("Genres/Franchises are not valid;\"%s\"\n", oldValue.toStdString().c_str()));
+      remove = true;
+    } else if(oldValue != res.value && !Skyscraper::config.pretend) {
+      findings.append(QString::asprintf("Genres/Franchises was not conformant, corrected;\"%s\";\"%s\"\n",
+                                        oldValue.toStdString().c_str(), res.value.toStdString().c_str()));
+      changed = true;
+    }
+  } else if(res.type == "players") {
+    QString oldValue = res.value;
+    res.value = StrTools::conformPlayers(res.value);
+    if(res.value.isEmpty()) {
+      findings.append(QString::asprintf("Players is not valid;\"%s\"\n", oldValue.toStdString().c_str()));
+      remove = true;
+    } else if(oldValue != res.value && !Skyscraper::config.pretend) {
+      findings.append(QString::asprintf("Players was not conformant, corrected;\"%s\";\"%s\"\n",
+                                        oldValue.toStdString().c_str(), res.value.toStdString().c_str()));
+      changed = true;
+    }
+  } else if(res.type == "rating") {
+    float rating = res.value.toFloat();
+    if(rating < 0.0 || rating > 1.0) {
+      findings.append(QString::asprintf("Rating is not a normalized value;\"%s\"\n", res.value.toStdString().c_str()));
+      if(res.source == "openretro" && !Skyscraper::config.pretend &&
+         rating <= 100.0 && rating > 1.0 ) {
+        res.value = QString::number(res.value.toDouble()/100.0);
+        findings.append(QString::asprintf("Rating was not conformant, corrected;\"%f\";\"%s\"\n",
+                                          rating, res.value.toStdString().c_str()));
+        changed = true;
+      } else {
         remove = true;
       }
-    } else if(res.type == "releasedate") {
+    } else if(rating == 0.0) {
+      findings.append("Rating is zero, removing;\n");
+      remove = true;
+    }
+  } else if(res.type == "video" || res.type == "manual" || res.type == "screenshot" ||
+            res.type == "cover" || res.type == "texture" || res.type == "marquee" ||
+            res.type == "wheel") {
+    QString resFile = cacheDir.absolutePath() + "/" + res.value;
+    if(!QFileInfo::exists(resFile)) {
+      findings.append(QString::asprintf("File does not exist;\"%s\"\n", resFile.toStdString().c_str()));
+      remove = true;
+    }
+  } else if(res.type == "timesplayed" || res.type == "timeplayed" ||
+            res.type == "firstplayed" || res.type == "lastplayed" ||
+            res.type == "disksize") {
+    bool validNumber = false;
+    if(res.value.toLongLong(&validNumber) <= 0 || !validNumber) {
+      findings.append(QString::asprintf("Invalid numeric value in custom flags;\"%s\"\n", res.value.toStdString().c_str()));
+      remove = true;
+    } else if(res.type == "disksize") {
       QString oldValue = res.value;
-      res.value = StrTools::conformReleaseDate(res.value);
-      if(res.value.isEmpty()) {
-        printf("Date is not valid;\"%s\"\n", oldValue.toStdString().c_str());
-        remove = true;
-      } else if(oldValue != res.value && !Skyscraper::config.pretend) {
-        printf("Date was not conformant, corrected;\"%s\";\"%s\"\n",
-               oldValue.toStdString().c_str(), res.value.toStdString().c_str());
-        it.setValue(res);
+      res.value = QString::number(NameTool->calculateGameSize(romFile));
+      if(oldValue != res.value && !Skyscraper::config.pretend) {
+        findings.append(QString::asprintf("Game size was incorrect, corrected;\"%s\";\"%s\"\n",
+                                          oldValue.toStdString().c_str(), res.value.toStdString().c_str()));
+        changed = true;
       }
-    } else if(res.type == "ages") {
-      QString oldValue = res.value;
-      res.value = StrTools::conformAges(res.value);
-      if(res.value.isEmpty()) {
-        printf("Age rating is not valid;\"%s\"\n", oldValue.toStdString().c_str());
+    }
+  } else if(res.type == "canonicalsize") {
+    QFileInfo source(romFile);
+    if(source.size() != res.value.toLongLong()) {
+      findings.append(QString::asprintf("Canonical file size does not match anymore;\"%s\";\"%lld\";\"%lld\"\n",
+                                        source.absoluteFilePath().toStdString().c_str(),
+                                        res.value.toLongLong(),
+                                        source.size()));
+      remove = true;
+    }
+  } else if(res.type == "canonicalcrc") {
+    if(!Skyscraper::config.skipChecksum) {
+      QFileInfo source(romFile);
+      CanonicalData romChecksums = fileChecksums(source);
+      if(romChecksums.crc != res.value) {
+        findings.append(QString::asprintf("CRC does not match the file checksum, deleting;\"%s\";\"%s\";\"%s\"\n",
+                                          source.absoluteFilePath().toStdString().c_str(),
+                                          res.value.toStdString().c_str(),
+                                          romChecksums.crc.toStdString().c_str()));
         remove = true;
-      } else if(oldValue != res.value && !Skyscraper::config.pretend) {
-        printf("Ages was not conformant, corrected;\"%s\";\"%s\"\n",
-               oldValue.toStdString().c_str(), res.value.toStdString().c_str());
-        it.setValue(res);
       }
-    } else if(res.type == "tags" || res.type == "franchises") {
-      QString oldValue = res.value;
-      res.value = StrTools::conformTags(res.value);
-      if(res.value.isEmpty()) {
-        printf("Genres/Franchises are not valid;\"%s\"\n", oldValue.toStdString().c_str());
+    }
+  } else if(res.type == "canonicalsha1") {
+    if(!Skyscraper::config.skipChecksum) {
+      QFileInfo source(romFile);
+      CanonicalData romChecksums = fileChecksums(source);
+      if(romChecksums.sha1 != res.value) {
+        findings.append(QString::asprintf("SHA1 does not match the file checksum, deleting;\"%s\";\"%s\";\"%s\"\n",
+                                          source.absoluteFilePath().toStdString().c_str(),
+                                          res.value.toStdString().c_str(),
+                                          romChecksums.sha1.toStdString().c_str()));
         remove = true;
-      } else if(oldValue != res.value && !Skyscraper::config.pretend) {
-        printf("Genres/Franchises was not conformant, corrected;\"%s\";\"%s\"\n",
-               oldValue.toStdString().c_str(), res.value.toStdString().c_str());
-        it.setValue(res);
       }
-    } else if(res.type == "players") {
-      QString oldValue = res.value;
-      res.value = StrTools::conformPlayers(res.value);
-      if(res.value.isEmpty()) {
-        printf("Players is not valid;\"%s\"\n", oldValue.toStdString().c_str());
-        remove = true;
-      } else if(oldValue != res.value && !Skyscraper::config.pretend) {
-        printf("Players was not conformant, corrected;\"%s\";\"%s\"\n",
-               oldValue.toStdString().c_str(), res.value.toStdString().c_str());
-        it.setValue(res);
-      }
-    } else if(res.type == "rating") {
-      float rating = res.value.toFloat();
-      if(rating < 0.0 || rating > 1.0) {
-        printf("Rating is not a normalized value;\"%s\"\n", res.value.toStdString().c_str());
-        if(res.source == "openretro" && !Skyscraper::config.pretend &&
-           rating <= 100.0 && rating > 1.0 ) {
-          res.value = QString::number(res.value.toDouble()/100.0);
-          printf("Rating was not conformant, corrected;\"%f\";\"%s\"\n",
-                 rating, res.value.toStdString().c_str());
-          it.setValue(res);
-        } else {
-          remove = true;
-        }
-      } else if(rating == 0.0) {
-        printf("Rating is zero, removing;\n");
+    }
+  } else if(res.type == "canonicalmd5") {
+    if(!Skyscraper::config.skipChecksum) {
+      QFileInfo source(romFile);
+      CanonicalData romChecksums = fileChecksums(source);
+      if(romChecksums.md5 != res.value) {
+        findings.append(QString::asprintf("MD5 does not match the file checksum, deleting;\"%s\";\"%s\";\"%s\"\n",
+                                          source.absoluteFilePath().toStdString().c_str(),
+                                          res.value.toStdString().c_str(),
+                                          romChecksums.md5.toStdString().c_str()));
         remove = true;
       }
-    } else if(res.type == "video" || res.type == "manual" || res.type == "screenshot" ||
-              res.type == "cover" || res.type == "texture" || res.type == "marquee" ||
-              res.type == "wheel") {
-      QString resFile = cacheDir.absolutePath() + "/" + res.value;
-      if(!QFileInfo::exists(resFile)) {
-        printf("File does not exist;\"%s\"\n", resFile.toStdString().c_str());
-        remove = true;
+    }
+  } else {
+    findings.append(QString::asprintf("Unknown resource type, deleting;\"%s\";\"%s\"\n",
+                                      res.type.toStdString().c_str(),
+                                      res.value.toStdString().c_str()));
+    remove = true;
+  }
+  return remove;
+}
+
+// Reads the checksums of a rom from checksums.cache when its size and modification time
+// are unchanged since they were calculated. Safe to call from several threads
+CanonicalData Cache::fileChecksums(const QFileInfo &info)
+{
+  const QString filePath = info.absoluteFilePath();
+  const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+  {
+    QMutexLocker locker(&checksumMutex);
+    auto it = checksums.constFind(filePath);
+    if(it != checksums.constEnd() && it.value().size == info.size() && it.value().mtime == mtime) {
+      CanonicalData canonical;
+      canonical.crc = it.value().crc;
+      canonical.sha1 = it.value().sha1;
+      canonical.md5 = it.value().md5;
+      return canonical;
+    }
+  }
+  CanonicalData canonical = NameTools::calculateChecksums(info);
+  if(info.exists()) {
+    FileChecksums fileChecksums;
+    fileChecksums.size = info.size();
+    fileChecksums.mtime = mtime;
+    fileChecksums.crc = canonical.crc;
+    fileChecksums.sha1 = canonical.sha1;
+    fileChecksums.md5 = canonical.md5;
+    QMutexLocker locker(&checksumMutex);
+    checksums.insert(filePath, fileChecksums);
+    checksumsChanged = true;
+  }
+  return canonical;
+}
+
+void Cache::readChecksums()
+{
+  QMutexLocker locker(&checksumMutex);
+  checksums.clear();
+  checksumsChanged = false;
+  QFile checksumsFile(cacheDir.absolutePath() + "/checksums.cache");
+  if(checksumsFile.open(QIODevice::ReadOnly)) {
+    QDataStream in(&checksumsFile);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if(magic == CHECKSUMSMAGIC && version == CHECKSUMSVERSION) {
+      in >> checksums;
+    }
+    if(in.status() != QDataStream::Ok) {
+      checksums.clear();
+    }
+    checksumsFile.close();
+  }
+}
+
+void Cache::writeChecksums()
+{
+  QMutexLocker locker(&checksumMutex);
+  if(!checksumsChanged) {
+    return;
+  }
+  // Forget roms that are gone, so the file doesn't keep growing as the romset changes
+  QMutableHashIterator<QString, FileChecksums> it(checksums);
+  while(it.hasNext()) {
+    it.next();
+    if(!QFileInfo::exists(it.key())) {
+      it.remove();
+    }
+  }
+  QSaveFile checksumsFile(cacheDir.absolutePath() + "/checksums.cache");
+  if(checksumsFile.open(QIODevice::WriteOnly)) {
+    QDataStream out(&checksumsFile);
+    out << CHECKSUMSMAGIC << CHECKSUMSVERSION << checksums;
+    if(checksumsFile.commit()) {
+      checksumsChanged = false;
+      return;
+    }
+  }
+  printf("Couldn't write '%s', the rom checksums will be calculated again on next validation.\n",
+         checksumsFile.fileName().toStdString().c_str());
+}
+
+QDataStream &operator<<(QDataStream &out, const FileChecksums &fileChecksums)
+{
+  out << fileChecksums.size << fileChecksums.mtime << fileChecksums.crc
+      << fileChecksums.sha1 << fileChecksums.md5;
+  return out;
+}
+
+QDataStream &operator>>(QDataStream &in, FileChecksums &fileChecksums)
+{
+  in >> fileChecksums.size >> fileChecksums.mtime >> fileChecksums.crc
+     >> fileChecksums.sha1 >> fileChecksums.md5;
+  return in;
+}
+
+// Prints the findings of a validation run and adds them to its report as they come in
+void Cache::reportFindings(const QString &findings)
+{
+  if(findings.isEmpty()) {
+    return;
+  }
+  QMutexLocker locker(&reportMutex);
+  printf("%s", findings.toStdString().c_str()); fflush(stdout);
+  if(validateReport.isOpen()) {
+    validateReport.write(findings.toUtf8());
+    validateReport.flush();
+  }
+}
+
+void Cache::verifyFiles(const QString &dirPath, const QString &resType,
+                        int &filesDeleted, int &filesNoDelete)
+{
+  QSet<QString> resFileNames;
+  const int resTypeId = typeId(resType);
+  for(const auto &bucket: std::as_const(resources)) {
+    const auto typeIdxs = bucket.ofType(resTypeId);
+    for(const auto idx: typeIdxs) {
+      QFileInfo resInfo(cacheDir.absolutePath() + "/" + bucket.resources.at(idx).value);
+      resFileNames.insert(resInfo.absoluteFilePath());
+    }
+  }
+
+  QDirIterator dirIt(dirPath, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+  while(dirIt.hasNext()) {
+    QFileInfo fileInfo(dirIt.next());
+    if(!resFileNames.contains(fileInfo.absoluteFilePath())) {
+      QString finding = "No resource entry for file '" + fileInfo.absoluteFilePath() + "', deleting... ";
+      if(QFile::remove(fileInfo.absoluteFilePath())) {
+        manifestRemove(fileInfo.absoluteFilePath());
+        finding.append("OK!\n");
+        filesDeleted++;
+      } else {
+        finding.append("ERROR! File couldn't be deleted :/\n");
+        filesNoDelete++;
       }
-    } else if(res.type == "timesplayed" || res.type == "timeplayed" ||
-              res.type == "firstplayed" || res.type == "lastplayed" ||
-              res.type == "disksize") {
-      bool validNumber = false;
-      if(res.value.toLongLong(&validNumber) <= 0 || !validNumber) {
-        printf("Invalid numeric value in custom flags;\"%s\"\n", res.value.toStdString().c_str());
-        remove = true;
-      } else if(res.type == "disksize") {
-        QString oldValue = res.value;
-        res.value = QString::number(NameTool->calculateGameSize(
-                                     getFileCacheId(res.cacheId).absoluteFilePath()));
-        if(oldValue != res.value && !Skyscraper::config.pretend) {
-          printf("Game size was incorrect, corrected;\"%s\";\"%s\"\n",
-                 oldValue.toStdString().c_str(), res.value.toStdString().c_str());
-          it.setValue(res);
+      reportFindings(finding);
+    }
+  }
+}
+
+// Streams the resources of the cache in 'mergeCacheFolder' into this one a batch at a time,
+// so the cache merged from never has to fit in memory
+void Cache::merge(const QString &mergeCacheFolder, const bool overwrite)
+{
+  printf("Merging databases, please wait...\n");
+  Cache mergeCache(mergeCacheFolder, globalScraper);
+  QDir mergeCacheDir(mergeCacheFolder);
+  // Merged resources are saved as they go, an interrupted merge is picked up by the journal
+  startJournal();
+
+  int resUpdated = 0;
+  int resMerged = 0;
+  bool ok = mergeCache.readStream([&](QVector<Resource> &mergeResources) {
+    mergeBatch(mergeResources, mergeCacheDir, overwrite, resUpdated, resMerged);
+  });
+  if(!ok) {
+    printf("\033[1;31mThe cache in '%s' is damaged or unreadable, only the resources read before the "
+           "error were merged.\033[0m\n", mergeCacheDir.absolutePath().toStdString().c_str());
+  }
+  printf("Successfully updated %d resource(s) in cache!\n", resUpdated);
+  printf("Successfully merged %d new resource(s) into cache!\n\n", resMerged);
+}
+
+void Cache::mergeBatch(QVector<Resource> &mergeResources, const QDir &mergeCacheDir,
+                       const bool overwrite, int &resUpdated, int &resMerged)
+{
+  // The merged cache can hold a resource more than once. Keep the one the destination
+  // would end up with, had they been merged one after the other: the last one when
+  // overwriting, the first one otherwise
+  QHash<QString, int> batchIndexes;
+  QVector<Resource> unique;
+  unique.reserve(mergeResources.size());
+  for(const auto &mergeResource: std::as_const(mergeResources)) {
+    const QString key = mergeResource.cacheId + "/" + mergeResource.type + "/" + mergeResource.source;
+    auto index = batchIndexes.constFind(key);
+    if(index == batchIndexes.constEnd()) {
+      batchIndexes.insert(key, unique.size());
+      unique.append(mergeResource);
+    } else if(overwrite) {
+      unique[index.value()] = mergeResource;
+    }
+  }
+  mergeResources.swap(unique);
+
+  QVector<Resource> accepted;
+  QList<QPair<QString, QString> > copies;
+  QSet<QString> copyDirs;
+  for(const auto &mergeResource: std::as_const(mergeResources)) {
+    bool resExists = false;
+    bool removed = false;
+    ResourceBucket *bucket = findBucket(mergeResource.cacheId);
+    if(bucket) {
+      // This type of iterator ensures we can delete items while iterating
+      QMutableVectorIterator<Resource> it(bucket->resources);
+      while(it.hasNext()) {
+        const Resource &res = it.next();
+        if(res.type == mergeResource.type &&
+           res.source == mergeResource.source) {
+          if(overwrite) {
+            if(isMedia(res.typeId)) {
+              if(QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
+                manifestRemove(cacheDir.absolutePath() + "/" + res.value);
+              } else {
+                printf("Couldn't remove media file '%s' for updating, skipping...\n",
+                       res.value.toStdString().c_str());
+                continue;
+              }
+            }
+            it.remove();
+            removed = true;
+          } else {
+            resExists = true;
+            break;
+          }
         }
       }
-    } else if(res.type == "canonicalsize") {
-      QFileInfo source = getFileCacheId(res.cacheId);
-      if(source.size() != res.value.toLongLong()) {
-        printf("Canonical file size does not match anymore;\"%s\";\"%lld\";\"%lld\"\n",
-             source.absoluteFilePath().toStdString().c_str(),
-             res.value.toLongLong(),
-             source.size());
-        remove = true;
+      pruneBucket(mergeResource.cacheId);
+    }
+    if(removed) {
+      journalRemove(mergeResource.cacheId, mergeResource.type, mergeResource.source);
+    }
+    if(!resExists) {
+      if(isMedia(mergeResource.typeId)) {
+        QString cacheFile = cacheDir.absolutePath() + "/" + mergeResource.value;
+        copies.append(qMakePair(mergeCacheDir.absolutePath() + "/" + mergeResource.value, cacheFile));
+        copyDirs.insert(QFileInfo(cacheFile).absolutePath());
       }
-    } else if(res.type == "canonicalcrc") {
-      if(!Skyscraper::config.skipChecksum) {
-        QFileInfo source = getFileCacheId(res.cacheId);
-        if(lastFileChecksumed != source.absoluteFilePath()) {
-          lastFileChecksumed = source.absoluteFilePath();
-          lastCanonicalData = NameTools::calculateChecksums(source);
-        }
-        if(lastCanonicalData.crc != res.value) {
-          printf("CRC does not match the file checksum, deleting;\"%s\";\"%s\";\"%s\"\n",
-                 source.absoluteFilePath().toStdString().c_str(),
-                 res.value.toStdString().c_str(),
-                 lastCanonicalData.crc.toStdString().c_str());
-          remove = true;
+      accepted.append(mergeResource);
+    }
+  }
+
+  for(const auto &copyDir: std::as_const(copyDirs)) {
+    cacheDir.mkpath(copyDir);
+  }
+  const QSet<QString> failedFiles = copyMediaFiles(copies);
+  for(const auto &mergeResource: std::as_const(accepted)) {
+    if(isMedia(mergeResource.typeId)) {
+      QString cacheFile = cacheDir.absolutePath() + "/" + mergeResource.value;
+      if(failedFiles.contains(cacheFile)) {
+        printf("Couldn't copy media file '%s', skipping...\n",
+               mergeResource.value.toStdString().c_str());
+        continue;
+      }
+      if(Skyscraper::config.cacheDedup) {
+        dedupMedia(cacheFile);
+      }
+      manifestAdd(cacheFile);
+    }
+    if(overwrite) {
+      resUpdated++;
+    } else {
+      resMerged++;
+    }
+    insertResource(mergeResource);
+    journalAdd(mergeResource);
+  }
+  // One transaction per batch, and the loaded roms can't be dropped before it's saved
+  flushJournal();
+  if(lazyLoad) {
+    // Everything is in the database by now, so the loaded roms can be dropped again
+    for(const auto &mergeResource: std::as_const(mergeResources)) {
+      resources.remove(mergeResource.cacheId);
+      loadedIds.remove(mergeResource.cacheId);
+    }
+  }
+}
+
+// Hard links the files where possible and copies them otherwise, on a small pool of I/O
+// threads. Returns the destinations that couldn't be created
+QSet<QString> Cache::copyMediaFiles(const QList<QPair<QString, QString> > &copies)
+{
+  QSet<QString> failedFiles;
+  if(copies.isEmpty()) {
+    return failedFiles;
+  }
+  QThreadPool ioPool;
+  ioPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), IOTHREADSMAX));
+  const int slices = qMin(ioPool.maxThreadCount(), copies.size());
+  const int sliceSize = (copies.size() + slices - 1) / slices;
+
+  QList<QFuture<QStringList> > futures;
+  for(int start = 0; start < copies.size(); start += sliceSize) {
+    const auto slice = copies.mid(start, sliceSize);
+    futures.append(QtConcurrent::run(&ioPool, [slice]() {
+      QStringList failed;
+      for(const auto &copy: slice) {
+        if(::link(QFile::encodeName(copy.first).constData(),
+                  QFile::encodeName(copy.second).constData()) != 0 &&
+           !QFile::copy(copy.first, copy.second)) {
+          failed.append(copy.second);
         }
       }
-    } else if(res.type == "canonicalsha1") {
-      if(!Skyscraper::config.skipChecksum) {
-        QFileInfo source = getFileCacheId(res.cacheId);
-        if(lastFileChecksumed != source.absoluteFilePath()) {
-          lastFileChecksumed = source.absoluteFilePath();
-          lastCanonicalData = NameTools::calculateChecksums(source);
+      return failed;
+    }));
+  }
+  for(auto &future: futures) {
+    const QStringList failed = future.result();
+    for(const auto &fileName: failed) {
+      failedFiles.insert(fileName);
+    }
+  }
+  return failedFiles;
+}
+
+// Reads the cache a batch of MERGEBATCH resources at a time instead of loading it
+bool Cache::readStream(const std::function<void(QVector<Resource> &)> &handleBatch)
+{
+  QString format = existingFormat();
+  sqliteBacked = (format == "sqlite");
+  QMap<QString, bool> idHash = readQuickIds();
+  QSet<QString> fileEntries = scanMedia();
+
+  QVector<Resource> batch;
+  auto add = [&](Resource &resource) {
+    resource.typeId = typeId(resource.type);
+    batch.append(resource);
+    if(batch.size() >= MERGEBATCH) {
+      handleBatch(batch);
+      batch.clear();
+    }
+  };
+
+  QStringList cacheFiles = { cacheFileName(format) };
+  if(format != "sqlite" && !QFileInfo::exists(cacheFiles.first())) {
+    cacheFiles.clear();
+    const QStringList sources = shardSources(format);
+    for(const auto &source: sources) {
+      cacheFiles.append(shardFileName(format, source));
+    }
+  }
+  bool ok = format == "sqlite"?readSqlite(fileEntries, idHash, add):!cacheFiles.isEmpty();
+  for(int a = 0; format != "sqlite" && ok && a < cacheFiles.size(); ++a) {
+    QFile cacheFile(cacheFiles.at(a));
+    if(!cacheFile.open(QIODevice::ReadOnly)) {
+      ok = false;
+      break;
+    }
+    if(format == "binary") {
+      ok = readBinary(cacheFile, fileEntries, idHash, add);
+    } else {
+      // Parsed one range of <resource> elements at a time
+      const qint64 size = cacheFile.size();
+      uchar *mapped = cacheFile.map(0, size);
+      QByteArray buffer;
+      if(mapped == nullptr) {
+        buffer = cacheFile.readAll();
+      }
+      const QByteArray raw = QByteArray::fromRawData(mapped != nullptr?reinterpret_cast<const char *>(mapped):
+                                                     buffer.constData(),
+                                                     mapped != nullptr?size:buffer.size());
+      const QList<int> bounds = xmlChunkBounds(raw, XMLCHUNKMIN);
+      const QString cachePath = cacheDir.absolutePath();
+      ok = true;
+      for(int a = 0; ok && a < bounds.size() - 1; ++a) {
+        XmlChunk chunk = parseXmlRange(raw, bounds, a, cachePath, fileEntries, idHash);
+        for(const auto &message: std::as_const(chunk.messages)) {
+          printf("%s", message.toStdString().c_str());
         }
-        if(lastCanonicalData.sha1 != res.value) {
-          printf("SHA1 does not match the file checksum, deleting;\"%s\";\"%s\";\"%s\"\n",
-                 source.absoluteFilePath().toStdString().c_str(),
-                 res.value.toStdString().c_str(),
-                 lastCanonicalData.sha1.toStdString().c_str());
-          remove = true;
+        for(auto &resource: chunk.resources) {
+          add(resource);
         }
+        ok = !chunk.error;
       }
-    } else if(res.type == "canonicalmd5") {
-      if(!Skyscraper::config.skipChecksum) {
-        QFileInfo source = getFileCacheId(res.cacheId);
-        if(lastFileChecksumed != source.absoluteFilePath()) {
-          lastFileChecksumed = source.absoluteFilePath();
-          lastCanonicalData = NameTools::calculateChecksums(source);
-        }
-        if(lastCanonicalData.md5 != res.value) {
-          printf("MD5 does not match the file checksum, deleting;\"%s\";\"%s\";\"%s\"\n",
-                 source.absoluteFilePath().toStdString().c_str(),
-                 res.value.toStdString().c_str(),
-                 lastCanonicalData.md5.toStdString().c_str());
-          remove = true;
-        }
+      if(mapped != nullptr) {
+        cacheFile.unmap(mapped);
       }
-    } else {
-      printf("Unknown resource type, deleting;\"%s\";\"%s\"\n",
-             res.type.toStdString().c_str(),
-             res.value.toStdString().c_str());
-      remove = true;
     }
-    if(remove) {
-      printf("Deleting inconsistent resource;\"%s\";\"%s\";\"%s\";\"%s\"\n",
-             res.cacheId.toStdString().c_str(),
-             res.source.toStdString().c_str(),
-             res.type.toStdString().c_str(),
-             res.value.toStdString().c_str());
-      if(!Skyscraper::config.pretend) {
-        it.remove();
-      }
-      resourcesDeleted++;
+    cacheFile.close();
+  }
+  if(!batch.isEmpty()) {
+    handleBatch(batch);
+  }
+  return ok;
+}
+
+QList<Resource> Cache::getResources()
+{
+  QList<Resource> allResources;
+  allResources.reserve(resourceCount());
+  for(const auto &bucket: std::as_const(resources)) {
+    for(const auto &resource: bucket.resources) {
+      allResources.append(resource);
     }
   }
+  return allResources;
+}
 
-  delete NameTool;
+int Cache::resourceCount()
+{
+  if(lazyLoad) {
+    // Only the roms looked up so far are in memory
+    flushJournal();
+    return qMax(readSqliteCounts(), 0);
+  }
+  int count = 0;
+  for(const auto &bucket: std::as_const(resources)) {
+    count += bucket.resources.size();
+  }
+  return count;
 }
 
-void Cache::verifyFiles(QDirIterator &dirIt, int &filesDeleted, int &filesNoDelete, QString resType)
+CacheLocker::CacheLocker(QReadWriteLock &lock, QAtomicInt &count, QAtomicInt &waits,
+                         const bool write)
+  : lock(lock), count(count), waits(waits), write(write)
 {
-  QStringList resFileNames;
-  for(const auto &resource: std::as_const(resources)) {
-    if(resource.type == resType) {
-      QFileInfo resInfo(cacheDir.absolutePath() + "/" + resource.value);
-      resFileNames.append(resInfo.absoluteFilePath());
+  relock();
+}
+
+CacheLocker::~CacheLocker()
+{
+  unlock();
+}
+
+void CacheLocker::unlock()
+{
+  if(locked) {
+    lock.unlock();
+    locked = false;
+  }
+}
+
+void CacheLocker::relock()
+{
+  if(locked) {
+    return;
+  }
+  count.ref();
+  if(write?!lock.tryLockForWrite():!lock.tryLockForRead()) {
+    waits.ref();
+    if(write) {
+      lock.lockForWrite();
+    } else {
+      lock.lockForRead();
     }
   }
+  locked = true;
+}
 
-  while(dirIt.hasNext()) {
-    QFileInfo fileInfo(dirIt.next());
-    if(!resFileNames.contains(fileInfo.absoluteFilePath())) {
-      printf("No resource entry for file '%s', deleting... ",
-             fileInfo.absoluteFilePath().toStdString().c_str()); fflush(stdout);
-      if(QFile::remove(fileInfo.absoluteFilePath())) {
-        printf("OK!\n");
-        filesDeleted++;
-      } else {
-        printf("ERROR! File couldn't be deleted :/\n");
-        filesNoDelete++;
+void Cache::printLockStats()
+{
+  printf("Cache lock waits: \033[1;33m%d\033[0m of %d acquisitions\n\n",
+         lockWaits.load(), lockCount.load());
+}
+
+// Lookup for callers only holding the read lock through 'locker'. It never loads a lazily
+// loaded rom itself, as that changes 'resources', so it loads it under the write lock
+// first. Another thread may have loaded it in between, which is why that is checked again
+const ResourceBucket *Cache::constBucket(const QString &cacheId, CacheLocker &locker)
+{
+  if(lazyLoad && !loadedIds.contains(cacheId)) {
+    locker.unlock();
+    {
+      CacheLocker writeLocker(cacheLock, lockCount, lockWaits, true);
+      if(!loadedIds.contains(cacheId)) {
+        loadBucket(cacheId);
       }
     }
+    locker.relock();
   }
+  // Looked up only now, the hash may have changed while the lock was released
+  auto it = resources.constFind(cacheId);
+  if(it == resources.constEnd()) {
+    return nullptr;
+  }
+  return &it.value();
 }
 
-QFileInfo Cache::getFileCacheId(const QString &cacheId)
+ResourceBucket *Cache::findBucket(const QString &cacheId)
 {
-  QFileInfo file;
-  const auto keys = quickIds.keys();
-  for(const auto &fileName: std::as_const(keys)) {
-    if(quickIds[fileName].second == cacheId) {
-      file = QFileInfo(fileName);
-      break;
-    }
+  // A rom may already have a bucket with only the resources added this run
+  if(lazyLoad && !loadedIds.contains(cacheId)) {
+    loadBucket(cacheId);
+  }
+  auto it = resources.find(cacheId);
+  if(it == resources.end()) {
+    return nullptr;
   }
-  return file;
+  return &it.value();
 }
 
-void Cache::merge(Cache &mergeCache, bool overwrite, const QString &mergeCacheFolder)
+QString Resource::text() const
 {
-  printf("Merging databases, please wait...\n");
-  QList<Resource> mergeResources = mergeCache.getResources();
+  if(packed.isEmpty()) {
+    return value;
+  }
+  return QString::fromUtf8(qUncompress(packed));
+}
 
-  QDir mergeCacheDir(mergeCacheFolder);
+// Only the free text types are compressed, they make up most of the cache but are
+// read once per game list entry at most
+void Resource::pack()
+{
+  if(!packed.isEmpty() || value.length() < PACKMIN ||
+     (typeId != DESCRIPTION && typeId != TRIVIA && typeId != GUIDES &&
+      typeId != CHEATS && typeId != REVIEWS)) {
+    return;
+  }
+  QByteArray compressed = qCompress(value.toUtf8());
+  if(compressed.size() < value.size() * (int)sizeof(QChar)) {
+    packed = compressed;
+    value = QString();
+  }
+}
 
-  int resUpdated = 0;
-  int resMerged = 0;
+QVector<int> ResourceBucket::ofType(const int typeId) const
+{
+  QVector<int> idxs;
+  for(int a = 0; a < resources.size(); ++a) {
+    if(resources.at(a).typeId == typeId) {
+      idxs.append(a);
+    }
+  }
+  return idxs;
+}
 
-  for(const auto &mergeResource: std::as_const(mergeResources)) {
-    bool resExists = false;
-    // This type of iterator ensures we can delete items while iterating
-    QMutableListIterator<Resource> it(resources);
-    while(it.hasNext()) {
-      Resource res = it.next();
-      if(res.cacheId == mergeResource.cacheId &&
-         res.type == mergeResource.type &&
-         res.source == mergeResource.source) {
-        if(overwrite) {
-          if(res.type == "cover" || res.type == "screenshot" ||
-             res.type == "wheel" || res.type == "marquee" ||
-             res.type == "texture" || res.type == "video" ||
-             res.type == "manual") {
-            if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
-              printf("Couldn't remove media file '%s' for updating, skipping...\n",
-                     res.value.toStdString().c_str());
-              continue;
-            }
+bool ResourceBucket::hasType(const int typeId) const
+{
+  if(typeId >= 0 && typeId < TYPECOUNT) {
+    return types & (Q_UINT64_C(1) << typeId);
+  }
+  for(const auto &resource: resources) {
+    if(resource.typeId == typeId) {
+      return true;
+    }
+  }
+  return false;
+}
 
-          }
-          it.remove();
-        } else {
-          resExists = true;
-          break;
-        }
-      }
+void ResourceBucket::updateTypes()
+{
+  types = 0;
+  for(const auto &resource: std::as_const(resources)) {
+    if(resource.typeId >= 0 && resource.typeId < TYPECOUNT) {
+      types |= Q_UINT64_C(1) << resource.typeId;
     }
-    if(!resExists) {
-      if(mergeResource.type == "cover" || mergeResource.type == "screenshot" ||
-         mergeResource.type == "wheel" || mergeResource.type == "marquee" ||
-         mergeResource.type == "texture" || mergeResource.type == "video" ||
-         mergeResource.type == "manual") {
-        cacheDir.mkpath(QFileInfo(cacheDir.absolutePath() + "/" + mergeResource.value).absolutePath());
-        if(!QFile::copy(mergeCacheDir.absolutePath() + "/" + mergeResource.value,
-                        cacheDir.absolutePath() + "/" + mergeResource.value)) {
-          printf("Couldn't copy media file '%s', skipping...\n",
-                 mergeResource.value.toStdString().c_str());
-          continue;
-        }
-      }
-      if(overwrite) {
-        resUpdated++;
-      } else {
-        resMerged++;
-      }
-      resources.append(mergeResource);
+  }
+}
+
+bool ResourceBucket::hasSource(const int sourceId) const
+{
+  for(const auto &resource: resources) {
+    if(resource.sourceId == sourceId) {
+      return true;
     }
   }
-  printf("Successfully updated %d resource(s) in cache!\n", resUpdated);
-  printf("Successfully merged %d new resource(s) into cache!\n\n", resMerged);
+  return false;
 }
 
-QList<Resource> Cache::getResources()
+int Cache::typeId(const QString &type)
+{
+  static const QHash<QString, int> typeIds = {
+    {"description", DESCRIPTION}, {"developer", DEVELOPER}, {"publisher", PUBLISHER},
+    {"players", PLAYERS}, {"tags", TAGS}, {"releasedate", RELEASEDATE},
+    {"cover", COVER}, {"screenshot", SCREENSHOT}, {"video", VIDEO},
+    {"rating", RATING}, {"wheel", WHEEL}, {"marquee", MARQUEE},
+    {"ages", AGES}, {"title", TITLE}, {"id", ID},
+    {"texture", TEXTURE}, {"franchises", FRANCHISES}, {"manual", MANUAL},
+    {"chiptuneid", CHIPTUNE}, {"guides", GUIDES}, {"platform", PLATFORM},
+    {"trivia", TRIVIA}, {"vgmaps", VGMAPS}, {"cheats", CHEATS},
+    {"reviews", REVIEWS}, {"artbooks", ARTBOOKS}, {"sprites", SPRITES},
+    {"chiptunepath", CHIPTUNEPATH}, {"disksize", DISKSIZE}, {"completed", COMPLETED},
+    {"favourite", FAVOURITE}, {"played", PLAYED}, {"timesplayed", TIMESPLAYED},
+    {"lastplayed", LASTPLAYED}, {"firstplayed", FIRSTPLAYED}, {"timeplayed", TIMEPLAYED},
+    {"canonicalname", CANONICALNAME}, {"canonicalmameid", CANONICALMAMEID},
+    {"canonicalfile", CANONICALFILE}, {"canonicalplatform", CANONICALPLATFORM},
+    {"canonicalsize", CANONICALSIZE}, {"canonicalcrc", CANONICALCRC},
+    {"canonicalsha1", CANONICALSHA1}, {"canonicalmd5", CANONICALMD5},
+    {"canonicalcatalog", CANONICALCATALOG}
+  };
+  return typeIds.value(type, -1);
+}
+
+bool Cache::isMedia(const int typeId)
+{
+  return typeId == COVER || typeId == SCREENSHOT || typeId == WHEEL ||
+         typeId == MARQUEE || typeId == TEXTURE || typeId == VIDEO ||
+         typeId == MANUAL;
+}
+
+// -1 for sources that no resource uses, which then never match
+int Cache::sourceId(const QString &source) const
+{
+  return sourceIds.value(source, -1);
+}
+
+void Cache::insertResource(const Resource &resource)
+{
+  auto it = resources.find(resource.cacheId);
+  if(it == resources.end()) {
+    it = resources.insert(resource.cacheId, ResourceBucket());
+  }
+  int source = sourceIds.value(resource.source, -1);
+  if(source == -1) {
+    source = sourceNames.size();
+    sourceIds.insert(resource.source, source);
+    sourceNames.append(resource.source);
+  }
+  auto type = typeNames.constFind(resource.type);
+  if(type == typeNames.constEnd()) {
+    type = typeNames.insert(resource.type, resource.type);
+  }
+  ResourceBucket &bucket = it.value();
+  bucket.resources.append(resource);
+  Resource &inserted = bucket.resources.last();
+  inserted.cacheId = it.key();
+  inserted.type = type.value();
+  inserted.typeId = typeId(resource.type);
+  inserted.source = sourceNames.at(source);
+  inserted.sourceId = source;
+  inserted.pack();
+  if(inserted.typeId >= 0 && inserted.typeId < TYPECOUNT) {
+    bucket.types |= Q_UINT64_C(1) << inserted.typeId;
+  }
+}
+
+// Drops the bucket once its last resource has been removed, or updates its types.
+// Called after resources have been removed from a bucket
+void Cache::pruneBucket(const QString &cacheId)
+{
+  auto it = resources.find(cacheId);
+  if(it == resources.end()) {
+    return;
+  }
+  if(it.value().resources.isEmpty()) {
+    resources.erase(it);
+  } else {
+    it.value().updateTypes();
+  }
+}
+
+// Empty 'type' or 'source' matches any
+void Cache::removeMatching(const QString &cacheId, const QString &type, const QString &source)
 {
-  return resources;
+  ResourceBucket *bucket = findBucket(cacheId);
+  if(!bucket) {
+    return;
+  }
+  QMutableVectorIterator<Resource> it(bucket->resources);
+  while(it.hasNext()) {
+    const Resource &res = it.next();
+    if((type.isEmpty() || res.type == type) &&
+       (source.isEmpty() || res.source == source)) {
+      it.remove();
+    }
+  }
+  pruneBucket(cacheId);
 }
 
 void Cache::addResources(GameEntry &entry, const Settings &config, QString &output)
@@ -2445,23 +4859,28 @@ void Cache::addResource(Resource &resource,
                         const Settings &config,
                         QString &output)
 {
-  QMutexLocker locker(&cacheMutex);
+  resource.typeId = typeId(resource.type);
+  CacheLocker locker(cacheLock, lockCount, lockWaits, true);
   bool notFound = true;
-  // This type of iterator ensures we can delete items while iterating
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
-    Resource res = it.next();
-    if(res.cacheId == resource.cacheId &&
-       res.type == resource.type &&
-       res.source == resource.source) {
-      if(config.refresh || config.rescan) {
-        it.remove();
-      } else {
-        notFound = false;
+  ResourceBucket *bucket = findBucket(resource.cacheId);
+  if(bucket) {
+    const auto typeIdxs = bucket->ofType(resource.typeId);
+    for(const auto idx: typeIdxs) {
+      if(bucket->resources.at(idx).source == resource.source) {
+        if(config.refresh || config.rescan) {
+          bucket->resources.removeAt(idx);
+          pruneBucket(resource.cacheId);
+          journalRemove(resource.cacheId, resource.type, resource.source);
+        } else {
+          notFound = false;
+        }
+        break;
       }
-      break;
     }
   }
+  // Decoding, resizing, encoding, writing and converting the media below is by far the
+  // slowest part. Only the resource records need the lock, so let other threads in
+  locker.unlock();
 
   if(notFound) {
     bool okToAppend = true;
@@ -2522,17 +4941,24 @@ void Cache::addResource(Resource &resource,
       }
       if(okToAppend) {
         if(imageFile->isEmpty() && imageData->size() > 0) {
+          // Never write through an existing file, it may be a link to a blob shared with others
+          QFile::remove(cacheFile);
           QFile f(cacheFile);
           if(f.open(QIODevice::WriteOnly)) {
             f.write(*imageData);
             f.close();
+            if(config.cacheDedup) {
+              dedupMedia(cacheFile, *imageData);
+            }
           } else {
             output.append("Error writing file: '" + f.fileName() +
                           "' to cache. Please check permissions.");
             okToAppend = false;
           }
-        } else if(!imageFile->isEmpty() && imageData->size() == 0) {
-          // For local files we do not generate an additional file, we link the original instead
+        } else if(!imageFile->isEmpty() && imageData->size() == 0 &&
+                  QDir::cleanPath(*imageFile) != QDir::cleanPath(cacheFile)) {
+          // For local files we do not generate an additional file, we link the original instead.
+          // Media resolved by fillBlanks() may already be this very cache file
           QFile f(*imageFile);
           if(QFileInfo::exists(cacheFile)) {
             QFile::remove(cacheFile);
@@ -2549,21 +4975,37 @@ void Cache::addResource(Resource &resource,
         imageFile->clear();
       }
     } else if(resource.type == "video") {
-      if(!entry.videoFile.isEmpty() && entry.videoData.size() == 0) {
-        // For local files we do not generate an additional file, we link the original instead
-        QFile f(entry.videoFile);
-        if(QFileInfo::exists(cacheFile)) {
-          QFile::remove(cacheFile);
-        }
-        if(!f.link(cacheFile)) {
-          okToAppend = false;
+      const bool downloaded = entry.videoData.size() == 0 && isDownload(entry.videoFile);
+      if(!entry.videoFile.isEmpty() && entry.videoData.size() == 0 && !downloaded) {
+        if(QDir::cleanPath(entry.videoFile) == QDir::cleanPath(cacheFile)) {
+          // Resolved by fillBlanks(), the file is already in place
+        } else {
+          // For local files we do not generate an additional file, we link the original instead
+          QFile f(entry.videoFile);
+          if(QFileInfo::exists(cacheFile)) {
+            QFile::remove(cacheFile);
+          }
+          if(!f.link(cacheFile)) {
+            okToAppend = false;
+          }
         }
       } else {
-        if(entry.videoData.size() <= config.videoSizeLimit) {
+        const qint64 videoSize = (downloaded?QFileInfo(entry.videoFile).size():entry.videoData.size());
+        if(videoSize <= config.videoSizeLimit) {
+          QString digest;
+          bool written = false;
           QFile f(cacheFile);
-          if(f.open(QIODevice::WriteOnly)) {
-            f.write(entry.videoData);
-            f.close();
+          if(downloaded) {
+            written = moveDownload(entry.videoFile, cacheFile, digest);
+          } else {
+            QFile::remove(cacheFile);
+            if(f.open(QIODevice::WriteOnly)) {
+              f.write(entry.videoData);
+              f.close();
+              written = true;
+            }
+          }
+          if(written) {
             if(!config.videoConvertCommand.isEmpty()) {
               output.append("Video conversion: ");
               if(doVideoConvert(resource,
@@ -2578,6 +5020,14 @@ void Cache::addResource(Resource &resource,
                 okToAppend = false;
               }
             }
+            if(okToAppend && config.cacheDedup) {
+              // A converted video has to be hashed from the file
+              if(config.videoConvertCommand.isEmpty()) {
+                dedupMedia(cacheFile, entry.videoData, digest);
+              } else {
+                dedupMedia(cacheFile);
+              }
+            }
           } else {
             output.append("Error writing file: '" + f.fileName() + "' to cache. Please check permissions.");
             okToAppend = false;
@@ -2591,21 +5041,40 @@ void Cache::addResource(Resource &resource,
         }
       }
     } else if(resource.type == "manual") {
-      if(!entry.manualFile.isEmpty() && entry.manualData.size() == 0) {
-        // For local files we do not generate an additional file, we link the original instead
-        QFile f(entry.manualFile);
-        if(QFileInfo::exists(cacheFile)) {
-          QFile::remove(cacheFile);
-        }
-        if(!f.link(cacheFile)) {
-          okToAppend = false;
+      const bool downloaded = entry.manualData.size() == 0 && isDownload(entry.manualFile);
+      if(!entry.manualFile.isEmpty() && entry.manualData.size() == 0 && !downloaded) {
+        if(QDir::cleanPath(entry.manualFile) == QDir::cleanPath(cacheFile)) {
+          // Resolved by fillBlanks(), the file is already in place
+        } else {
+          // For local files we do not generate an additional file, we link the original instead
+          QFile f(entry.manualFile);
+          if(QFileInfo::exists(cacheFile)) {
+            QFile::remove(cacheFile);
+          }
+          if(!f.link(cacheFile)) {
+            okToAppend = false;
+          }
         }
       } else {
-        if(entry.manualData.size() <= config.manualSizeLimit) {
+        const qint64 manualSize = (downloaded?QFileInfo(entry.manualFile).size():entry.manualData.size());
+        if(manualSize <= config.manualSizeLimit) {
+          QString digest;
+          bool written = false;
           QFile f(cacheFile);
-          if(f.open(QIODevice::WriteOnly)) {
-            f.write(entry.manualData);
-            f.close();
+          if(downloaded) {
+            written = moveDownload(entry.manualFile, cacheFile, digest);
+          } else {
+            QFile::remove(cacheFile);
+            if(f.open(QIODevice::WriteOnly)) {
+              f.write(entry.manualData);
+              f.close();
+              written = true;
+            }
+          }
+          if(written) {
+            if(config.cacheDedup) {
+              dedupMedia(cacheFile, entry.manualData, digest);
+            }
           } else {
             output.append("Error writing file: '" + f.fileName() + "' to cache. Please check permissions.");
             okToAppend = false;
@@ -2621,7 +5090,27 @@ void Cache::addResource(Resource &resource,
     }
 
     if(okToAppend) {
-      resources.append(resource);
+      locker.relock();
+      bool exists = false;
+      bucket = findBucket(resource.cacheId);
+      if(bucket) {
+        const auto typeIdxs = bucket->ofType(resource.typeId);
+        for(const auto idx: typeIdxs) {
+          if(bucket->resources.at(idx).source == resource.source) {
+            exists = true;
+            break;
+          }
+        }
+      }
+      // Another thread may have added the same resource while the lock was released
+      if(!exists) {
+        insertResource(resource);
+        journalAdd(resource);
+      }
+      locker.unlock();
+      if(isMedia(resource.typeId)) {
+        manifestAdd(cacheAbsolutePath + "/" + resource.value);
+      }
     } else {
       printf("\033[1;33mWarning! Couldn't add resource to cache. "
              "Resource size limit exceeded or error writing the "
@@ -2721,11 +5210,14 @@ bool Cache::hasAlpha(const QImage &image)
 
 void Cache::addQuickId(const QFileInfo &info, const QString &cacheId)
 {
+  const QString key = fileKey(info.absoluteFilePath());
   QMutexLocker locker(&quickIdMutex);
   QPair<qint64, QString> pair; // Quick id pair
   pair.first = info.lastModified().toMSecsSinceEpoch();
   pair.second = cacheId;
   quickIds[info.absoluteFilePath()] = pair;
+  addFileKey(info.absoluteFilePath(), key);
+  journalQuickId(info.absoluteFilePath(), pair, key);
 }
 
 QString Cache::getQuickId(const QFileInfo &info)
@@ -2736,158 +5228,176 @@ QString Cache::getQuickId(const QFileInfo &info)
      info.lastModified().toMSecsSinceEpoch() <= quickIds[info.absoluteFilePath()].first */ ) {
     return quickIds[info.absoluteFilePath()].second;
   }
-  return QString();
+  // A renamed or moved rom keeps its inode, so it is recognized without hashing it again.
+  // Roms identified by their file name get a new cache id with their new name
+  if(fileKeyIds.isEmpty() || !NameTools::cacheIdFromData(info)) {
+    return QString();
+  }
+  const QString key = fileKey(info.absoluteFilePath());
+  QPair<qint64, QString> pair;
+  pair.first = info.lastModified().toMSecsSinceEpoch();
+  pair.second = fileKeyIds.value(key + ":" + QString::number(pair.first));
+  if(key.isEmpty() || pair.second.isEmpty()) {
+    return QString();
+  }
+  quickIds[info.absoluteFilePath()] = pair;
+  addFileKey(info.absoluteFilePath(), key);
+  journalQuickId(info.absoluteFilePath(), pair, key);
+  return pair.second;
+}
+
+// Expects 'quickIds' to already hold the file
+void Cache::addFileKey(const QString &filePath, const QString &fileKey)
+{
+  if(fileKey.isEmpty()) {
+    return;
+  }
+  quickIdKeys[filePath] = fileKey;
+  const QPair<qint64, QString> &pair = quickIds[filePath];
+  fileKeyIds[fileKey + ":" + QString::number(pair.first)] = pair.second;
 }
 
-bool Cache::hasEntries(const QString &cacheId, const QString scraper)
+// Works out the cache ids of the roms without a quick id several at a time, before the
+// scraping threads would otherwise hash them one by one. Returns how many were hashed
+int Cache::hashMissingQuickIds(const QList<QFileInfo> &files)
 {
-  QMutexLocker locker(&cacheMutex);
-  for(const auto &res: std::as_const(resources)) {
-    if(scraper.isEmpty()) {
-      if(res.cacheId == cacheId) {
-        return true;
-      }
-    } else {
-      if(res.cacheId == cacheId && res.source == scraper) {
-        return true;
+  QList<QFileInfo> missing;
+  for(const auto &info: files) {
+    if(getQuickId(info).isEmpty()) {
+      missing.append(info);
+    }
+  }
+  if(missing.isEmpty()) {
+    return 0;
+  }
+  printf("Calculating cache ids of %d roms without a quick id, please wait... ", missing.size());
+  fflush(stdout);
+  QThreadPool ioPool;
+  ioPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), IOTHREADSMAX));
+  QList<QFuture<void> > futures;
+  for(const auto &info: std::as_const(missing)) {
+    futures.append(QtConcurrent::run(&ioPool, [this, info]() {
+      // Roms that fail are left to the scraping threads, which report the error
+      const QString cacheId = NameTools::getCacheId(info);
+      if(!cacheId.isEmpty()) {
+        addQuickId(info, cacheId);
       }
-    }
+    }));
   }
-  return false;
+  for(auto &future: futures) {
+    future.waitForFinished();
+  }
+  printf("\033[1;32mDone!\033[0m\n\n");
+  return missing.size();
+}
+
+bool Cache::hasEntries(const QString &cacheId, const QString scraper)
+{
+  CacheLocker locker(cacheLock, lockCount, lockWaits, false);
+  if(scraper.isEmpty() && shardTypes.contains(cacheId)) {
+    return true;
+  }
+  const ResourceBucket *bucket = constBucket(cacheId, locker);
+  if(!bucket) {
+    return false;
+  }
+  return scraper.isEmpty() || bucket->hasSource(sourceId(scraper));
 }
 
 bool Cache::removeResources(const QString &cacheId, const QString scraper)
 {
   bool removed = false;
-  QMutexLocker locker(&cacheMutex);
-  QMutableListIterator<Resource> it(resources);
+  CacheLocker locker(cacheLock, lockCount, lockWaits, true);
+  if(scraper.isEmpty()) {
+    removed = resources.remove(cacheId) > 0;
+    if(removed) {
+      journalRemove(cacheId, "", "");
+    }
+    return removed;
+  }
+  ResourceBucket *bucket = findBucket(cacheId);
+  const int scraperId = sourceId(scraper);
+  if(!bucket || !bucket->hasSource(scraperId)) {
+    return false;
+  }
+  QMutableVectorIterator<Resource> it(bucket->resources);
   while(it.hasNext()) {
-    Resource res = it.next();
-    if(scraper.isEmpty()) {
-      if(res.cacheId == cacheId) {
-        it.remove();
-        removed = true;
-      }
-    } else {
-      if(res.cacheId == cacheId && res.source == scraper) {
-        it.remove();
-        removed = true;
-      }
+    if(it.next().sourceId == scraperId) {
+      it.remove();
+      removed = true;
     }
   }
+  pruneBucket(cacheId);
+  journalRemove(cacheId, "", scraper);
   return removed;
 }
 
 bool Cache::hasMeaningfulEntries(const QString &cacheId, const QString scraper, bool reverseLogic)
 {
-  QMutexLocker locker(&cacheMutex);
-  for(const auto &res: std::as_const(resources)) {
+  CacheLocker locker(cacheLock, lockCount, lockWaits, false);
+  auto isCustomFlag = [](const int type) {
+    return type == COMPLETED || type == FAVOURITE || type == PLAYED ||
+           type == TIMESPLAYED || type == LASTPLAYED || type == FIRSTPLAYED ||
+           type == TIMEPLAYED || type == DISKSIZE;
+  };
+  auto isMeaningful = [this, &isCustomFlag](const int type) {
+    // We consider non-meaningful the barebone fields (title and platform),
+    // as well as those resources that are only provided by a single scraper,
+    // unless we are scraping using that scraper precisely.
+    if(type == ID || type == TITLE || type == PLATFORM ||
+       type == CANONICALNAME || type == CANONICALMAMEID || type == CANONICALFILE ||
+       type == CANONICALPLATFORM || type == CANONICALSIZE || type == CANONICALCRC ||
+       type == CANONICALSHA1 || type == CANONICALMD5) {
+      return false;
+    }
+    if(globalScraper == "vgmaps") {
+      return type == VGMAPS;
+    } else if(globalScraper == "sprites") {
+      return type == SPRITES;
+    } else if(globalScraper == "vgfacts") {
+      return type == TRIVIA;
+    } else if(globalScraper == "docsdb") {
+      return type == GUIDES || type == CHEATS || type == REVIEWS || type == ARTBOOKS;
+    } else if(globalScraper == "exodos" || globalScraper == "gamebase") {
+      return type == GUIDES || type == CHEATS || type == VGMAPS || type == ARTBOOKS ||
+             type == CHIPTUNE || type == CHIPTUNEPATH;
+    } else if(globalScraper == "gamefaqs") {
+      return type == GUIDES;
+    } else if(globalScraper == "chiptune") {
+      return type == CHIPTUNE || type == CHIPTUNEPATH;
+    } else if(globalScraper == "customflags") {
+      return isCustomFlag(type);
+    } else if(globalScraper == "cache") {
+      return !isCustomFlag(type);
+    }
+    return !isCustomFlag(type) &&
+           type != GUIDES && type != CHEATS && type != REVIEWS &&
+           type != ARTBOOKS && type != VGMAPS && type != SPRITES &&
+           type != TRIVIA && type != CHIPTUNE && type != CHIPTUNEPATH;
+  };
+  const ResourceBucket *bucket = constBucket(cacheId, locker);
+  // The shards that weren't loaded never hold the resources of the current scraper
+  if(scraper.isEmpty() || reverseLogic) {
+    quint64 types = shardTypes.value(cacheId);
+    if(scraper.isEmpty() && bucket) {
+      types |= bucket->types;
+    }
+    for(int type = 0; types && type < TYPECOUNT; ++type) {
+      if((types & (Q_UINT64_C(1) << type)) && isMeaningful(type)) {
+        return true;
+      }
+    }
+  }
+  if(!bucket || scraper.isEmpty()) {
+    return false;
+  }
+  const int scraperId = sourceId(scraper);
+  for(const auto &res: std::as_const(bucket->resources)) {
     if(scraper.isEmpty() ||
-       (res.source == scraper && !reverseLogic) ||
-       (res.source != scraper && reverseLogic)) {
-      // We consider non-meaningful the barebone fields (title and platform),
-      // as well as those resources that are only provided by a single scraper,
-      // unless we are scraping using that scraper precisely.
-      if(res.cacheId == cacheId && res.type != "id"
-                                && res.type != "title"
-                                && res.type != "platform"
-                                && res.type != "canonicalname"
-                                && res.type != "canonicalmameid"
-                                && res.type != "canonicalfile"
-                                && res.type != "canonicalplatform"
-                                && res.type != "canonicalsize"
-                                && res.type != "canonicalcrc"
-                                && res.type != "canonicalsha1"
-                                && res.type != "canonicalmd5") {
-        if(globalScraper == "vgmaps") {
-          if(res.type == "vgmaps") {
-            return true;
-          }
-        } else if(globalScraper == "sprites") {
-          if(res.type == "sprites") {
-            return true;
-          }
-        } else if(globalScraper == "vgfacts") {
-          if(res.type == "trivia") {
-            return true;
-          }
-        } else if(globalScraper == "docsdb") {
-          if(res.type == "guides"  ||
-             res.type == "cheats"  ||
-             res.type == "reviews" ||
-             res.type == "artbooks") {
-            return true;
-          }
-        } else if(globalScraper == "exodos") {
-          if(res.type == "guides"  ||
-             res.type == "cheats"  ||
-             res.type == "vgmaps" ||
-             res.type == "artbooks" ||
-             res.type == "chiptuneid" ||
-             res.type == "chiptunepath") {
-            return true;
-          }
-        } else if(globalScraper == "gamebase") {
-          if(res.type == "guides"  ||
-             res.type == "cheats"  ||
-             res.type == "vgmaps" ||
-             res.type == "artbooks" ||
-             res.type == "chiptuneid" ||
-             res.type == "chiptunepath") {
-            return true;
-          }
-        } else if(globalScraper == "gamefaqs") {
-          if(res.type == "guides") {
-            return true;
-          }
-        } else if(globalScraper == "chiptune") {
-          if(res.type == "chiptuneid" ||
-             res.type == "chiptunepath") {
-            return true;
-          }
-        } else if(globalScraper == "customflags") {
-          if(res.type == "completed" ||
-             res.type == "favourite" ||
-             res.type == "played" ||
-             res.type == "timesplayed" ||
-             res.type == "lastplayed" ||
-             res.type == "firstplayed" ||
-             res.type == "timeplayed" ||
-             res.type == "disksize") {
-            return true;
-          }
-        } else if(globalScraper == "cache") {
-          if(res.type != "completed" &&
-             res.type != "favourite" &&
-             res.type != "played" &&
-             res.type != "timesplayed" &&
-             res.type != "lastplayed" &&
-             res.type != "firstplayed" &&
-             res.type != "timeplayed" &&
-             res.type != "disksize") {
-            return true;
-          }
-        } else {
-          if(res.type != "completed" &&
-             res.type != "favourite" &&
-             res.type != "played" &&
-             res.type != "timesplayed" &&
-             res.type != "lastplayed" &&
-             res.type != "firstplayed" &&
-             res.type != "timeplayed" &&
-             res.type != "disksize" &&
-             res.type != "guides" &&
-             res.type != "cheats" &&
-             res.type != "reviews" &&
-             res.type != "artbooks" &&
-             res.type != "vgmaps" &&
-             res.type != "sprites" &&
-             res.type != "trivia" &&
-             res.type != "chiptuneid" &&
-             res.type != "chiptunepath") {
-            return true;
-          }
-        }
+       (res.sourceId == scraperId && !reverseLogic) ||
+       (res.sourceId != scraperId && reverseLogic)) {
+      if(isMeaningful(res.typeId)) {
+        return true;
       }
     }
   }
@@ -2896,432 +5406,422 @@ bool Cache::hasMeaningfulEntries(const QString &cacheId, const QString scraper,
 
 bool Cache::hasEntriesOfType(const QString &cacheId, const QString &type, const QString scraper)
 {
-  QMutexLocker locker(&cacheMutex);
-  for(const auto &res: std::as_const(resources)) {
-    if(scraper.isEmpty() || res.source == scraper) {
-      if(res.cacheId == cacheId && res.type == type) {
-        return true;
-      }
+  CacheLocker locker(cacheLock, lockCount, lockWaits, false);
+  const int typeIdx = typeId(type);
+  if(scraper.isEmpty() && typeIdx >= 0 && (shardTypes.value(cacheId) & (Q_UINT64_C(1) << typeIdx))) {
+    return true;
+  }
+  const ResourceBucket *bucket = constBucket(cacheId, locker);
+  if(!bucket) {
+    return false;
+  }
+  if(scraper.isEmpty()) {
+    return bucket->hasType(typeIdx);
+  }
+  const int scraperId = sourceId(scraper);
+  const auto typeIdxs = bucket->ofType(typeIdx);
+  for(const auto idx: typeIdxs) {
+    if(scraper.isEmpty() || bucket->resources.at(idx).sourceId == scraperId) {
+      return true;
     }
   }
   return false;
 }
 
+// The types of the resources of a rom as a bit per type id. Only those of 'scraper'
+// if one is given
+quint64 Cache::typeMask(const QString &cacheId, const QString scraper)
+{
+  CacheLocker locker(cacheLock, lockCount, lockWaits, false);
+  quint64 types = 0;
+  if(scraper.isEmpty()) {
+    types = shardTypes.value(cacheId);
+  }
+  const ResourceBucket *bucket = constBucket(cacheId, locker);
+  if(!bucket) {
+    return types;
+  }
+  if(scraper.isEmpty()) {
+    return types | bucket->types;
+  }
+  // The types of a single module decide whether its resources are complete. Like in
+  // fillBlanks(), media only counts when its file is still there, so a lost file is
+  // fetched again
+  const int scraperId = sourceId(scraper);
+  for(const auto &res: std::as_const(bucket->resources)) {
+    if(res.sourceId != scraperId || res.typeId < 0 || res.typeId >= TYPECOUNT) {
+      continue;
+    }
+    const quint64 bit = Q_UINT64_C(1) << res.typeId;
+    if((types & bit) == 0 &&
+       (!isMedia(res.typeId) || QFileInfo::exists(cacheDir.absolutePath() + "/" + res.value))) {
+      types |= bit;
+    }
+  }
+  return types;
+}
+
 void Cache::fillBlanks(GameEntry &entry, const QString scraper)
 {
-  QMutexLocker locker(&cacheMutex);
-  QList<Resource> matchingResources;
-  // Find all resources related to this particular rom
-  for(const auto &resource: std::as_const(resources)) {
-    if(scraper.isEmpty()) {
-      if(entry.cacheId == resource.cacheId) {
-        matchingResources.append(resource);
-      }
-    } else {
-      if(entry.cacheId == resource.cacheId &&
-         (resource.source == scraper || resource.source == "generic")) {
-        matchingResources.append(resource);
+  CacheLocker locker(cacheLock, lockCount, lockWaits, false);
+  // Sort the resources of this particular rom by type in a single pass. Only pointers
+  // are kept, the bucket stays untouched as long as the lock is held
+  QVector<QVector<const Resource *> > byType(TYPECOUNT);
+  const ResourceBucket *bucket = constBucket(entry.cacheId, locker);
+  if(bucket) {
+    const int scraperId = sourceId(scraper);
+    const int genericId = sourceId("generic");
+    for(const auto &resource: std::as_const(bucket->resources)) {
+      if(resource.typeId >= 0 &&
+         (scraper.isEmpty() || resource.sourceId == scraperId || resource.sourceId == genericId)) {
+        byType[resource.typeId].append(&resource);
       }
     }
   }
 
   {
-    QString type = "id";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(ID, byType, result, source)) {
       entry.id = result;
       entry.idSrc = source;
     }
   }
   {
-    QString type = "title";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(TITLE, byType, result, source)) {
       entry.title = result;
       entry.titleSrc = source;
     }
   }
   {
-    QString type = "platform";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(PLATFORM, byType, result, source)) {
       entry.platform = result;
       entry.platformSrc = source;
     }
   }
   {
-    QString type = "canonicalname";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALNAME, byType, result, source)) {
       entry.canonical.name = result;
     }
   }
   {
-    QString type = "canonicalmameid";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALMAMEID, byType, result, source)) {
       entry.canonical.mameid = result;
     }
   }
   {
-    QString type = "canonicalfile";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALFILE, byType, result, source)) {
       entry.canonical.file = result;
     }
   }
   {
-    QString type = "canonicalcatalog";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALCATALOG, byType, result, source)) {
       entry.canonical.platform = result;
     }
   }
   {
-    QString type = "canonicalsize";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALSIZE, byType, result, source)) {
       entry.canonical.size = result.toLongLong();
     }
   }
   {
-    QString type = "canonicalcrc";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALCRC, byType, result, source)) {
       entry.canonical.crc = result;
     }
   }
   {
-    QString type = "canonicalsha1";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALSHA1, byType, result, source)) {
       entry.canonical.sha1 = result;
     }
   }
   {
-    QString type = "canonicalmd5";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CANONICALMD5, byType, result, source)) {
       entry.canonical.md5 = result;
     }
   }
   {
-    QString type = "description";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(DESCRIPTION, byType, result, source)) {
       entry.description = result;
       entry.descriptionSrc = source;
     }
   }
   {
-    QString type = "publisher";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(PUBLISHER, byType, result, source)) {
       entry.publisher = result;
       entry.publisherSrc = source;
     }
   }
   {
-    QString type = "developer";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(DEVELOPER, byType, result, source)) {
       entry.developer = result;
       entry.developerSrc = source;
     }
   }
   {
-    QString type = "players";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(PLAYERS, byType, result, source)) {
       entry.players = result;
       entry.playersSrc = source;
     }
   }
   {
-    QString type = "ages";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(AGES, byType, result, source)) {
       entry.ages = result;
       entry.agesSrc = source;
     }
   }
   {
-    QString type = "tags";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(TAGS, byType, result, source)) {
       entry.tags = result;
       entry.tagsSrc = source;
     }
   }
   {
-    QString type = "franchises";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(FRANCHISES, byType, result, source)) {
       entry.franchises = result;
       entry.franchisesSrc = source;
     }
   }
   {
-    QString type = "rating";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(RATING, byType, result, source)) {
       entry.rating = result;
       entry.ratingSrc = source;
     }
   }
   {
-    QString type = "releasedate";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(RELEASEDATE, byType, result, source)) {
       entry.releaseDate = result;
       entry.releaseDateSrc = source;
     }
   }
   {
-    QString type = "guides";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(GUIDES, byType, result, source)) {
       entry.guides = result;
       entry.guidesSrc = source;
     }
   }
   {
-    QString type = "cheats";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CHEATS, byType, result, source)) {
       entry.cheats = result;
       entry.cheatsSrc = source;
     }
   }
   {
-    QString type = "reviews";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(REVIEWS, byType, result, source)) {
       entry.reviews = result;
       entry.reviewsSrc = source;
     }
   }
   {
-    QString type = "artbooks";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(ARTBOOKS, byType, result, source)) {
       entry.artbooks = result;
       entry.artbooksSrc = source;
     }
   }
   {
-    QString type = "vgmaps";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(VGMAPS, byType, result, source)) {
       entry.vgmaps = result;
       entry.vgmapsSrc = source;
     }
   }
   {
-    QString type = "sprites";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(SPRITES, byType, result, source)) {
       entry.sprites = result;
       entry.spritesSrc = source;
     }
   }
   {
-    QString type = "trivia";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(TRIVIA, byType, result, source)) {
       entry.trivia = result;
       entry.triviaSrc = source;
     }
   }
   {
-    QString type = "chiptuneid";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CHIPTUNE, byType, result, source)) {
       entry.chiptuneId = result;
       entry.chiptuneIdSrc = source;
     }
   }
   {
-    QString type = "chiptunepath";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(CHIPTUNEPATH, byType, result, source)) {
       entry.chiptunePath = result;
       entry.chiptunePathSrc = source;
     }
   }
   {
-    QString type = "completed";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(COMPLETED, byType, result, source)) {
       entry.completed = (result=="true") ? true : false;
     }
   }
   {
-    QString type = "favourite";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(FAVOURITE, byType, result, source)) {
       entry.favourite = (result=="true") ? true : false;
     }
   }
   {
-    QString type = "played";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(PLAYED, byType, result, source)) {
       entry.played = (result=="true") ? true : false;
     }
   }
   {
-    QString type = "timesplayed";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(TIMESPLAYED, byType, result, source)) {
       entry.timesPlayed = result.toUInt();
     }
   }
   {
-    QString type = "lastplayed";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(LASTPLAYED, byType, result, source)) {
       entry.lastPlayed = result.toLongLong();
     }
   }
   {
-    QString type = "firstplayed";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(FIRSTPLAYED, byType, result, source)) {
       entry.firstPlayed = result.toLongLong();
     }
   }
   {
-    QString type = "timeplayed";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(TIMEPLAYED, byType, result, source)) {
       entry.timePlayed = result.toLongLong();
     }
   }
   {
-    QString type = "disksize";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(DISKSIZE, byType, result, source)) {
       entry.diskSize = result.toLongLong();
     }
   }
+  // Media is only resolved to its path in the cache. The bytes are read on demand
+  // with GameEntry::loadMedia() by whoever actually needs them
   {
-    QString type = "cover";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
-      QFile f(cacheDir.absolutePath() + "/" + result);
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.coverData = f.readAll();
-        entry.coverFile = f.fileName();
-        f.close();
+    if(fillType(COVER, byType, result, source)) {
+      QString fileName = cacheDir.absolutePath() + "/" + result;
+      if(QFileInfo::exists(fileName)) {
+        entry.coverFile = fileName;
       }
       entry.coverSrc = source;
     }
   }
   {
-    QString type = "screenshot";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
-      QFile f(cacheDir.absolutePath() + "/" + result);
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.screenshotData = f.readAll();
-        entry.screenshotFile = f.fileName();
-        f.close();
+    if(fillType(SCREENSHOT, byType, result, source)) {
+      QString fileName = cacheDir.absolutePath() + "/" + result;
+      if(QFileInfo::exists(fileName)) {
+        entry.screenshotFile = fileName;
       }
       entry.screenshotSrc = source;
     }
   }
   {
-    QString type = "wheel";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
-      QFile f(cacheDir.absolutePath() + "/" + result);
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.wheelData = f.readAll();
-        entry.wheelFile = f.fileName();
-        f.close();
+    if(fillType(WHEEL, byType, result, source)) {
+      QString fileName = cacheDir.absolutePath() + "/" + result;
+      if(QFileInfo::exists(fileName)) {
+        entry.wheelFile = fileName;
       }
       entry.wheelSrc = source;
     }
   }
   {
-    QString type = "marquee";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
-      QFile f(cacheDir.absolutePath() + "/" + result);
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.marqueeData = f.readAll();
-        entry.marqueeFile = f.fileName();
-        f.close();
+    if(fillType(MARQUEE, byType, result, source)) {
+      QString fileName = cacheDir.absolutePath() + "/" + result;
+      if(QFileInfo::exists(fileName)) {
+        entry.marqueeFile = fileName;
       }
       entry.marqueeSrc = source;
     }
   }
   {
-    QString type = "texture";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
-      QFile f(cacheDir.absolutePath() + "/" + result);
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.textureData = f.readAll();
-        entry.textureFile = f.fileName();
-        f.close();
+    if(fillType(TEXTURE, byType, result, source)) {
+      QString fileName = cacheDir.absolutePath() + "/" + result;
+      if(QFileInfo::exists(fileName)) {
+        entry.textureFile = fileName;
       }
       entry.textureSrc = source;
     }
   }
   {
-    QString type = "video";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(VIDEO, byType, result, source)) {
       QFileInfo info(cacheDir.absolutePath() + "/" + result);
-      QFile f(info.absoluteFilePath());
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.videoData = f.readAll();
-        f.close();
+      if(info.exists()) {
         entry.videoFormat = info.suffix();
         entry.videoFile = info.absoluteFilePath();
         entry.videoSrc = source;
@@ -3329,15 +5829,11 @@ void Cache::fillBlanks(GameEntry &entry, const QString scraper)
     }
   }
   {
-    QString type = "manual";
     QString result = "";
     QString source = "";
-    if(fillType(type, matchingResources, result, source)) {
+    if(fillType(MANUAL, byType, result, source)) {
       QFileInfo info(cacheDir.absolutePath() + "/" + result);
-      QFile f(info.absoluteFilePath());
-      if(f.open(QIODevice::ReadOnly)) {
-        entry.manualData = f.readAll();
-        f.close();
+      if(info.exists()) {
         entry.manualFormat = info.suffix();
         entry.manualFile = info.absoluteFilePath();
         entry.manualSrc = source;
@@ -3346,89 +5842,83 @@ void Cache::fillBlanks(GameEntry &entry, const QString scraper)
   }
 }
 
-bool Cache::fillType(QString &type, QList<Resource> &matchingResources,
+bool Cache::fillType(const int type, const QVector<QVector<const Resource *> > &byType,
                      QString &result, QString &source)
 {
-  QList<Resource> typeResources;
-  for(const auto &resource: std::as_const(matchingResources)) {
-    if(resource.type == type) {
-      typeResources.append(resource);
-    }
-  }
+  const QVector<const Resource *> &typeResources = byType.at(type);
   if(typeResources.isEmpty()) {
     return false;
   }
-  if(type == "description") {
+  if(type == DESCRIPTION) {
     // Use the longest description across scrapers while avoiding extremely long
     // descriptions if possible (typically GiantBomb):
     int descriptionLength = 0;
-    QString longDescriptionValue;
-    QString longDescriptionSource;
-    for(const auto &resource: std::as_const(typeResources)) {
-      if(resource.value.length() > descriptionLength && resource.value.length() < 2048) {
-        result = resource.value;
-        source = resource.source;
-        descriptionLength = resource.value.length();
-      } else if(resource.value.length() < 2048) {
-        longDescriptionValue = resource.value;
-        longDescriptionSource = resource.source;
-      }
-    }
-    if(!descriptionLength && !longDescriptionValue.isEmpty()) {
-        result = longDescriptionValue;
-        source = longDescriptionSource;
+    const Resource *longDescription = nullptr;
+    for(const auto *resource: typeResources) {
+      const QString description = resource->text();
+      if(description.length() > descriptionLength && description.length() < 2048) {
+        result = description;
+        source = resource->source;
+        descriptionLength = description.length();
+      } else if(description.length() < 2048) {
+        longDescription = resource;
+      }
+    }
+    if(!descriptionLength && longDescription && !longDescription->text().isEmpty()) {
+        result = longDescription->text();
+        source = longDescription->source;
         return true;
     } else {
       if(descriptionLength) {
         return true;
       }
     }
-  } else if(/*type == "franchises" || type == "tags" ||*/
-            type == "vgmaps"   || type == "sprites" ||
-            type == "cheats"   || type == "guides"  ||
-            type == "artbooks" || type == "reviews" ||
-            type == "trivia"   || type == "id" ) {
+  } else if(/*type == FRANCHISES || type == TAGS ||*/
+            type == VGMAPS   || type == SPRITES ||
+            type == CHEATS   || type == GUIDES  ||
+            type == ARTBOOKS || type == REVIEWS ||
+            type == TRIVIA   || type == ID) {
     // Concatenate together all the scrapers contents:
     QStringList allCanonical;
     QString separator = ";";
-    if(type == "franchises" || type == "tags") {
+    if(type == FRANCHISES || type == TAGS) {
       separator = ", ";
-    } else if(type == "trivia") {
+    } else if(type == TRIVIA) {
       separator = "\n\n";
-    } else if(type == "id") {
+    } else if(type == ID) {
       separator = ",";
     }
-    for(const auto &resource: std::as_const(typeResources)) {
-      if(type == "id") {
+    for(const auto *resource: typeResources) {
+      if(type == ID) {
         if(allCanonical.isEmpty()) {
-          allCanonical.append("skyscraper:" + resource.cacheId);
+          allCanonical.append("skyscraper:" + resource->cacheId);
         }
-        allCanonical.append(resource.source + ":" + resource.value);
+        allCanonical.append(resource->source + ":" + resource->value);
       } else {
-        allCanonical.append(resource.value.split(separator));
+        allCanonical.append(resource->text().split(separator));
       }
-      source = resource.source;
+      source = resource->source;
     }
     if(typeResources.size() > 1) {
       source = "multiple";
     }
     allCanonical.removeDuplicates();
-    if(type != "trivia") {
+    if(type != TRIVIA) {
       allCanonical.sort();
     }
     result = allCanonical.join(separator);
     return true;
-  } else if(type == "rating") {
+  } else if(type == RATING) {
     float rating = 0;
     int emptyScore = 0;
-    for(const auto &resource: std::as_const(typeResources)) {
-      double score = resource.value.toFloat();
+    for(const auto *resource: typeResources) {
+      double score = resource->value.toFloat();
       if(score) {
         rating += score;
       } else {
         emptyScore++;
       }
-      source = resource.source;
+      source = resource->source;
     }
     if(typeResources.size() > 1) {
       source = "multiple";
@@ -3437,45 +5927,51 @@ bool Cache::fillType(QString &type, QList<Resource> &matchingResources,
     result = QString::number(rating, 'f', 2);
     return true;
   } else {
-    if(prioMap.contains(type)) {
-      for(int a = 0; a < prioMap.value(type).length(); ++a) {
-        for(const auto &resource: std::as_const(typeResources)) {
-          if(resource.source == prioMap.value(type).at(a)) {
-            result = resource.value;
-            source = resource.source;
-            if(type == "franchises" || type == "tags") {
-              QStringList allCanonical, all = result.split(", ");
-              for(const auto &single: std::as_const(all)) {
-                if(type == "franchises"  && canonicalFranchises.contains(single)) {
-                  if(canonicalFranchises[single] != "DELETE") {
-                    allCanonical.append(canonicalFranchises[single]);
-                  }
-                } else if(type == "tags"  && canonicalGenres.contains(single)) {
-                  if(canonicalGenres[single] != "DELETE") {
-                    allCanonical.append(canonicalGenres[single]);
-                  }
-                } else {
-                  allCanonical.append(single);
-                }
+    auto ranksIt = prioRanks.constFind(type);
+    if(ranksIt != prioRanks.constEnd()) {
+      const Resource *best = nullptr;
+      int bestRank = 0;
+      for(const auto *resource: typeResources) {
+        int rank = ranksIt.value().value(resource->source, -1);
+        if(rank != -1 && (!best || rank < bestRank)) {
+          best = resource;
+          bestRank = rank;
+        }
+      }
+      if(best) {
+        result = best->text();
+        source = best->source;
+        if(type == FRANCHISES || type == TAGS) {
+          QStringList allCanonical, all = result.split(", ");
+          for(const auto &single: std::as_const(all)) {
+            if(type == FRANCHISES && canonicalFranchises.contains(single)) {
+              if(canonicalFranchises.value(single) != "DELETE") {
+                allCanonical.append(canonicalFranchises.value(single));
+              }
+            } else if(type == TAGS && canonicalGenres.contains(single)) {
+              if(canonicalGenres.value(single) != "DELETE") {
+                allCanonical.append(canonicalGenres.value(single));
               }
-              allCanonical.removeDuplicates();
-              allCanonical.sort();
-              result = allCanonical.join(", ");
+            } else {
+              allCanonical.append(single);
             }
-            return true;
           }
+          allCanonical.removeDuplicates();
+          allCanonical.sort();
+          result = allCanonical.join(", ");
         }
+        return true;
       }
     }
   }
   qint64 newest = 0;
   // If there is no priority set for the resource type nor it is a Description,
   // then the most recently scraped resource is selected:
-  for(const auto &resource: std::as_const(typeResources)) {
-    if(resource.timestamp >= newest) {
-      newest = resource.timestamp;
-      result = resource.value;
-      source = resource.source;
+  for(const auto *resource: typeResources) {
+    if(resource->timestamp >= newest) {
+      newest = resource->timestamp;
+      result = resource->text();
+      source = resource->source;
     }
   }
   return true;
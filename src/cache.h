@@ -29,23 +29,82 @@
 #include <QObject>
 #include <QString>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+#include <QFile>
 #include <QDirIterator>
 #include <QMap>
+#include <QVector>
+#include <QHash>
+#include <QMultiHash>
+#include <QSet>
+#include <QSqlDatabase>
 #include <QSharedPointer>
+#include <QDataStream>
+
+#include <functional>
 
 #include "gameentry.h"
 #include "queue.h"
 #include "settings.h"
 
+// The members are ordered by size so the struct has no padding between them
 struct Resource {
   QString cacheId = "";
-  int version = 1;
   QString type = "";
   QString source = "";
   QString value = "";
+  // Long texts such as descriptions are kept zlib compressed in here instead of in
+  // 'value' once inserted into the cache. Use text() to read the value of those
+  QByteArray packed;
   qint64 timestamp = 0;
+  int version = 1;
+  // Set by Cache::insertResource(), which also makes the strings above share their
+  // data with every other resource of the same cache id, type and source
+  qint16 typeId = -1; // See gameentry.h
+  qint16 sourceId = -1;
+  QString text() const;
+  void pack();
+};
+Q_DECLARE_TYPEINFO(Resource, Q_MOVABLE_TYPE);
+
+// All resources connected to a single cache id. Buckets only hold a few dozen
+// resources, so scanning their type and source ids beats per-bucket hash indexes
+struct ResourceBucket {
+  QVector<Resource> resources;
+  // Bit per type id of the resources above, kept up to date by Cache::insertResource()
+  // and Cache::pruneBucket()
+  quint64 types = 0;
+  QVector<int> ofType(const int typeId) const;
+  bool hasType(const int typeId) const;
+  bool hasSource(const int sourceId) const;
+  void updateTypes();
+};
+
+// One folder of cached media files as recorded in media.manifest. 'files' maps the
+// file name to its size and modification time
+struct MediaDir {
+  qint64 mtime = 0;
+  QStringList subDirs;
+  QHash<QString, QPair<qint64, qint64> > files;
+};
+
+QDataStream &operator<<(QDataStream &out, const MediaDir &mediaDir);
+QDataStream &operator>>(QDataStream &in, MediaDir &mediaDir);
+
+// Checksums of a rom as recorded in checksums.cache. Only valid while the size and
+// modification time still match the file
+struct FileChecksums {
+  qint64 size = 0;
+  qint64 mtime = 0;
+  QString crc;
+  QString sha1;
+  QString md5;
 };
 
+QDataStream &operator<<(QDataStream &out, const FileChecksums &fileChecksums);
+QDataStream &operator>>(QDataStream &in, FileChecksums &fileChecksums);
+
 struct ResCounts {
   int ids;
   int titles;
@@ -76,12 +135,36 @@ struct ResCounts {
   int chiptunes;
 };
 
+class NameTools;
+
+// Scoped lock on the cache that counts how often a thread had to wait for it
+class CacheLocker
+{
+public:
+  CacheLocker(QReadWriteLock &lock, QAtomicInt &count, QAtomicInt &waits, const bool write);
+  ~CacheLocker();
+  void unlock();
+  void relock();
+
+private:
+  QReadWriteLock &lock;
+  QAtomicInt &count;
+  QAtomicInt &waits;
+  bool write;
+  bool locked = false;
+};
+
 class Cache
 {
 public:
   Cache(const QString &cacheFolder, const QString &scraper);
+  ~Cache();
   bool createFolders();
+  void flushJournal();
+  static QString downloadFolder(const QString &cacheFolder);
+  bool isDownload(const QString &fileName);
   bool read();
+  bool readSubset(const QList<QFileInfo> &files);
   void printPriorities(QString cacheId);
   void editResources(QSharedPointer<Queue> queue,
                      const QString &command = "",
@@ -94,7 +177,7 @@ public:
   void assembleReport(const Settings &config, const QString filters);
   void showStats(int verbosity);
   void readPriorities();
-  bool write(const bool onlyQuickId = false);
+  bool write(const bool onlyQuickId = false, const QString &format = "");
   void validate();
   void addResources(GameEntry &entry, const Settings &config, QString &output);
   void fillBlanks(GameEntry &entry, const QString scraper = "");
@@ -104,20 +187,65 @@ public:
   bool hasEntriesOfType(const QString &cacheId, const QString &type, const QString scraper = "");
   void addQuickId(const QFileInfo &info, const QString &cacheId);
   QString getQuickId(const QFileInfo &info);
-  void merge(Cache &mergeCache, bool overwrite, const QString &mergeCacheFolder);
+  int hashMissingQuickIds(const QList<QFileInfo> &files);
+  void merge(const QString &mergeCacheFolder, const bool overwrite);
   QList<Resource> getResources();
+  int resourceCount();
+  bool startJournal();
+  void printLockStats();
+  quint64 typeMask(const QString &cacheId, const QString scraper = "");
+  static int typeId(const QString &type);
+  static bool isMedia(const int typeId);
 
  private:
   QList<QFileInfo> getFileInfos(const QString &inputFolder, const QString &filter, const bool subdirs = true);
   QStringList getCacheIdList(const QList<QFileInfo> &fileInfos);
-  QFileInfo getFileCacheId(const QString &cacheId);
+  bool readXml(QFile &cacheFile, const QSet<QString> &fileEntries, const QMap<QString, bool> &idHash);
+  bool readBinary(QFile &cacheFile, const QSet<QString> &fileEntries, const QMap<QString, bool> &idHash,
+                  const std::function<void(Resource &)> &handleResource);
+  bool writeXml(QFile &cacheFile, const QStringList &cacheIds, const int onlySource = -1);
+  bool writeBinary(QFile &cacheFile, const QStringList &cacheIds, const int onlySource = -1);
+  bool writeSqlite(const bool onlyQuickId);
+  QString cacheFileName(const QString &format);
+  void moveOtherFormatsAside(const QString &format, const bool sharded = false);
+  QSqlDatabase database();
+  void closeDatabase();
+  bool readSqliteSummary();
+  int readSqliteCounts();
+  void applySqlite(const QList<QByteArray> &records);
+  bool readSqlite(const QSet<QString> &fileEntries, const QMap<QString, bool> &idHash,
+                  const std::function<void(Resource &)> &handleResource);
+  QString existingFormat();
+  bool hasCacheFile(const QString &format);
+  QStringList shardSources(const QString &format);
+  QString shardFileName(const QString &format, const QString &source);
+  bool readShards(const QString &format, const QMap<QString, bool> &idHash);
+  bool readShardIndex(const QString &format, const QString &source);
+  bool writeShards(const QString &format);
+  QMap<QString, bool> readQuickIds();
+  QByteArray filterXmlSubset(const QByteArray &raw, const QMap<QString, bool> &idHash);
+  bool readStream(const std::function<void(QVector<Resource> &)> &handleBatch);
+  void mergeBatch(QVector<Resource> &mergeResources, const QDir &mergeCacheDir,
+                  const bool overwrite, int &resUpdated, int &resMerged);
+  QSet<QString> copyMediaFiles(const QList<QPair<QString, QString> > &copies);
+  void loadBucket(const QString &cacheId);
+  void sqliteAdd(const Resource &resource);
+  void sqliteRemove(const QString &cacheId, const QString &type, const QString &source);
+  void sqliteQuickId(const QString &filePath, const QPair<qint64, QString> &quickId,
+                     const QString &fileKey);
 
-  void addToResCounts(const QString source, const QString type);
+  void addToResCounts(const QString source, const QString type, const int count = 1);
   void addResource(Resource &resource, GameEntry &entry, const QString &cacheAbsolutePath,
                    const Settings &config, QString &output);
-  void verifyFiles(QDirIterator &dirIt, int &filesDeleted, int &noDelete, QString resType);
+  void verifyFiles(const QString &dirPath, const QString &resType, int &filesDeleted, int &filesNoDelete);
   void verifyResources(int &resourcesDeleted);
-  bool fillType(QString &type, QList<Resource> &matchingResources,
+  bool verifyResource(Resource &res, bool &changed, const QString &romFile,
+                      NameTools *NameTool, QString &findings);
+  CanonicalData fileChecksums(const QFileInfo &info);
+  void readChecksums();
+  void writeChecksums();
+  void reportFindings(const QString &findings);
+  bool fillType(const int type, const QVector<QVector<const Resource *> > &byType,
                 QString &result, QString &source);
   bool doVideoConvert(Resource &resource,
                       QString &cacheFile,
@@ -125,16 +253,94 @@ public:
                       const Settings &config,
                       QString &output);
   bool hasAlpha(const QImage &image);
+  ResourceBucket *findBucket(const QString &cacheId);
+  const ResourceBucket *constBucket(const QString &cacheId, CacheLocker &locker);
+  void insertResource(const Resource &resource);
+  int sourceId(const QString &source) const;
+  void pruneBucket(const QString &cacheId);
+  void removeMatching(const QString &cacheId, const QString &type, const QString &source);
+  void journalAdd(const Resource &resource);
+  void journalRemove(const QString &cacheId, const QString &type, const QString &source);
+  void journalQuickId(const QString &filePath, const QPair<qint64, QString> &quickId,
+                      const QString &fileKey = QString());
+  void addFileKey(const QString &filePath, const QString &fileKey);
+  void appendJournal(const QByteArray &record);
+  void resetJournal();
+  int replayJournal(QMap<QString, bool> &idHash);
   void loadCanonicalMap(const QString &json, QMap<QString, QString> *canonicalMap);
+  QSet<QString> scanMedia(const bool rescanAll = false);
+  void scanMediaDir(const QString &dirPath, QHash<QString, MediaDir> &scanned,
+                    const bool rescanAll, int &rescanned);
+  void manifestAdd(const QString &fileName);
+  void manifestRemove(const QString &fileName);
+  void writeManifest();
+  int removeListed(const QHash<QString, QVector<int> > &doomed, const int verbosity = 0);
+  QSet<QString> removeMediaFiles(const QStringList &fileNames);
+  void dedupMedia(const QString &fileName, const QByteArray &data = QByteArray(),
+                  const QString &digest = QString());
+  bool moveDownload(const QString &fileName, const QString &cacheFile, QString &digest);
+  int collectBlobs();
 
   QDir cacheDir;
-  QMutex cacheMutex;
+  // Lookups share the lock, anything changing 'resources' takes it exclusively
+  QReadWriteLock cacheLock;
+  QAtomicInt lockCount;
+  QAtomicInt lockWaits;
   QMutex quickIdMutex;
+  QMutex journalMutex; // Guards 'pendingRecords'
+  QMutex flushMutex; // Guards 'journalFile' and keeps flushes in order
+  QMutex manifestMutex;
+
+  // Write-ahead journal of changes made since db.xml was last written. Only
+  // open during scraping runs, replayed by read() and emptied by write()
+  QFile journalFile;
+  // Journal records of changes made under the cache lock. They are only written to the
+  // journal or the database by flushJournal(), which runs outside of the lock
+  QList<QByteArray> pendingRecords;
+
+  // Set when the cache lives in db.sqlite. Changes are then written straight to the
+  // database and, when 'lazyLoad' is set, roms are only loaded once first looked up
+  bool sqliteBacked = false;
+  bool lazyLoad = false;
+  QSet<QString> loadedIds;
+
+  // Set by readSubset() when only the resources of the queued roms were loaded. The
+  // cache files are then never rewritten, changes are kept in the journal instead
+  bool subsetLoad = false;
+  QSet<QString> subsetFiles;
+  QMutex dbConnectionsMutex;
+  QStringList dbConnections;
+
+  // Media files in the cache folder, so read() only has to list the folders whose
+  // modification time changed since the manifest was written
+  QHash<QString, MediaDir> mediaDirs; // Folder relative to cacheDir -> its files
+  QSet<QString> dirtyMediaDirs;
+  bool manifestLoaded = false;
+
+  // Rom checksums and the report of the current '--cache validate' run
+  QMutex checksumMutex;
+  QHash<QString, FileChecksums> checksums; // Absolute rom path -> its checksums
+  bool checksumsChanged = false;
+  QMutex reportMutex;
+  QFile validateReport;
+
+  // Set when the cache is split into one file per source in 'shards'. Scraping runs only
+  // load the shards they need, the others are summed up in 'shardTypes'
+  QSet<QString> loadedShards;
+  bool partialShards = false;
+  QHash<QString, quint64> shardTypes; // cacheId -> bit per type id held by unloaded shards
 
-  QMap<QString, QStringList > prioMap;
+  QHash<int, QHash<QString, int> > prioRanks; // typeId -> source -> rank, lowest wins
   QMap<QString, ResCounts> resCountsMap;
-  QList<Resource> resources;
+  QHash<QString, ResourceBucket> resources; // cacheId -> all resources of that rom
+  QHash<QString, QString> typeNames;
+  QHash<QString, int> sourceIds;
+  QStringList sourceNames; // Indexed by Resource::sourceId
   QMap<QString, QPair<qint64, QString> > quickIds; // filePath, timestamp + cacheId for quick lookup
+  // Device, inode and size of the file behind a quick id. A renamed or moved rom is found in
+  // 'fileKeyIds' (file key + timestamp -> cacheId) by those and doesn't have to be hashed again
+  QHash<QString, QString> quickIdKeys;
+  QHash<QString, QString> fileKeyIds;
 
   QMap<QString, QString> canonicalGenres;
   QMap<QString, QString> canonicalFranchises;
@@ -300,6 +300,16 @@ void Compositor::addChildLayers(Layer &layer, QXmlStreamReader &xml)
 
 void Compositor::saveAll(GameEntry &game, QString completeBaseName)
 {
+  // Only read the cached media that the artwork recipe actually uses. This has to
+  // happen up front, as the loop below points the *File members to the outputs.
+  if(!config->symlinkImages) {
+    QSet<QString> usedResources;
+    collectResources(outputs, usedResources);
+    for(const auto &resource: std::as_const(usedResources)) {
+      game.loadMedia(resource);
+    }
+  }
+
   for(auto &output: outputs.getLayers()) {
     QString filename = "/" + completeBaseName + ".png";
     bool generateThumbnail = false;
@@ -318,14 +328,14 @@ void Compositor::saveAll(GameEntry &game, QString completeBaseName)
             isAutogenerated = true;
           }
         }
-        if((isAutogenerated && game.coverData.isEmpty()) ||
-           (!isAutogenerated && !game.coverData.isEmpty() && !config->symlinkImages)) {
+        if((isAutogenerated && !game.hasMedia("cover")) ||
+           (!isAutogenerated && game.hasMedia("cover") && !config->symlinkImages)) {
           game.coverFile = filename;
           continue;
-        } else if(!isAutogenerated && game.coverData.isEmpty()) {
+        } else if(!isAutogenerated && !game.hasMedia("cover")) {
           generateThumbnail = true;
         }
-      } else if(game.coverData.isEmpty()) {
+      } else if(!game.hasMedia("cover")) {
         generateThumbnail = true;
       }
       if(generateThumbnail) {
@@ -351,40 +361,40 @@ void Compositor::saveAll(GameEntry &game, QString completeBaseName)
       }
     } else if(output.resType == "screenshot") {
       filename.prepend(config->screenshotsFolder);
-      if(game.screenshotData.isEmpty() && QFileInfo::exists(filename)) {
+      if(!game.hasMedia("screenshot") && QFileInfo::exists(filename)) {
         QFile::remove(filename);
       } else if(config->skipExistingScreenshots &&
-              !game.screenshotData.isEmpty() &&
+              game.hasMedia("screenshot") &&
               QFileInfo::exists(filename)) {
         game.screenshotFile = filename;
         continue;
       }
     } else if(output.resType == "wheel") {
       filename.prepend(config->wheelsFolder);
-      if(game.wheelData.isEmpty() && QFileInfo::exists(filename)) {
+      if(!game.hasMedia("wheel") && QFileInfo::exists(filename)) {
         QFile::remove(filename);
       } else if(config->skipExistingWheels &&
-              !game.wheelData.isEmpty() &&
+              game.hasMedia("wheel") &&
               QFileInfo::exists(filename)) {
         game.wheelFile = filename;
         continue;
       }
     } else if(output.resType == "marquee") {
       filename.prepend(config->marqueesFolder);
-      if(game.marqueeData.isEmpty() && QFileInfo::exists(filename)) {
+      if(!game.hasMedia("marquee") && QFileInfo::exists(filename)) {
         QFile::remove(filename);
       } else if(config->skipExistingMarquees &&
-              !game.marqueeData.isEmpty() &&
+              game.hasMedia("marquee") &&
               QFileInfo::exists(filename)) {
         game.marqueeFile = filename;
         continue;
       }
     } else if(output.resType == "texture") {
       filename.prepend(config->texturesFolder);
-      if(game.textureData.isEmpty() && QFileInfo::exists(filename)) {
+      if(!game.hasMedia("texture") && QFileInfo::exists(filename)) {
         QFile::remove(filename);
       } else if(config->skipExistingTextures &&
-              !game.textureData.isEmpty() &&
+              game.hasMedia("texture") &&
               QFileInfo::exists(filename)) {
         game.textureFile = filename;
         continue;
@@ -420,6 +430,14 @@ void Compositor::saveAll(GameEntry &game, QString completeBaseName)
           QFile::link(sourceFile, filename);
         }
       } else {
+        if(config->symlinkImages) {
+          // Reached for autogenerated covers only, nothing was preloaded above
+          QSet<QString> usedResources = {"cover"};
+          collectResources(output, usedResources);
+          for(const auto &resource: std::as_const(usedResources)) {
+            game.loadMedia(resource);
+          }
+        }
         output.setCanvas(QImage::fromData(game.coverData));
         if(output.canvas.isNull() && output.hasLayers()) {
           QImage tmpImage(10, 10, QImage::Format_ARGB32_Premultiplied);
@@ -543,6 +561,16 @@ void Compositor::saveAll(GameEntry &game, QString completeBaseName)
   }
 }
 
+void Compositor::collectResources(Layer &layer, QSet<QString> &resources)
+{
+  for(auto &child: layer.getLayers()) {
+    if(!child.resource.isEmpty()) {
+      resources.insert(child.resource);
+    }
+    collectResources(child, resources);
+  }
+}
+
 void Compositor::processChildLayers(GameEntry &game, Layer &layer)
 {
   for(int a = 0; a < layer.getLayers().length(); ++a) {
@@ -28,6 +28,7 @@
 
 #include <QImage>
 #include <QXmlStreamReader>
+#include <QSet>
 
 #include "settings.h"
 #include "gameentry.h"
@@ -45,6 +46,7 @@ public:
 private:
   void addChildLayers(Layer &layer, QXmlStreamReader &xml);
   void processChildLayers(GameEntry &game, Layer &layer);
+  void collectResources(Layer &layer, QSet<QString> &resources);
   Settings *config;
   Layer outputs;
 
@@ -23,6 +23,8 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
  */
 
+#include <QFile>
+
 #include "gameentry.h"
 #include "skyscraper.h"
 
@@ -252,9 +254,65 @@ void GameEntry::resetMedia()
   manualData.clear();
 }
 
-int GameEntry::getCompleteness() const
+bool GameEntry::mediaFields(const QString &resource, QByteArray *&data, QString *&file)
+{
+  if(resource == "cover") {
+    data = &coverData;
+    file = &coverFile;
+  } else if(resource == "screenshot") {
+    data = &screenshotData;
+    file = &screenshotFile;
+  } else if(resource == "wheel") {
+    data = &wheelData;
+    file = &wheelFile;
+  } else if(resource == "marquee") {
+    data = &marqueeData;
+    file = &marqueeFile;
+  } else if(resource == "texture") {
+    data = &textureData;
+    file = &textureFile;
+  } else if(resource == "video") {
+    data = &videoData;
+    file = &videoFile;
+  } else if(resource == "manual") {
+    data = &manualData;
+    file = &manualFile;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool GameEntry::hasMedia(const QString &resource) const
+{
+  QByteArray *data = nullptr;
+  QString *file = nullptr;
+  if(!const_cast<GameEntry *>(this)->mediaFields(resource, data, file)) {
+    return false;
+  }
+  return !data->isEmpty() || !file->isEmpty();
+}
+
+bool GameEntry::loadMedia(const QString &resource)
+{
+  QByteArray *data = nullptr;
+  QString *file = nullptr;
+  if(!mediaFields(resource, data, file)) {
+    return false;
+  }
+  if(data->isEmpty() && !file->isEmpty()) {
+    QFile f(*file);
+    if(f.open(QIODevice::ReadOnly)) {
+      *data = f.readAll();
+      f.close();
+    }
+  }
+  return !data->isEmpty();
+}
+
+// Number of resource types a complete entry has for the selected scraper and options
+int GameEntry::completenessTypes()
 {
-  double completeness = 0.0;
   int noOfTypes = 17;
   if(Skyscraper::config.videos) {
     noOfTypes += 1;
@@ -375,7 +433,13 @@ int GameEntry::getCompleteness() const
     if(Skyscraper::config.videos) noOfTypes++;
     if(Skyscraper::config.manuals) noOfTypes++;
   }
-  double valuePerType = 100.0 / (double)noOfTypes;
+  return noOfTypes;
+}
+
+int GameEntry::getCompleteness() const
+{
+  double completeness = 0.0;
+  double valuePerType = 100.0 / (double)completenessTypes();
   if(!id.isEmpty()) {
     completeness += valuePerType;
   }
@@ -460,6 +524,44 @@ int GameEntry::getCompleteness() const
   return (int)completeness;
 }
 
+// Completeness of an entry filled from cached resources of the types set in 'types'
+// (bit per type id), without having to fill it
+int GameEntry::getCompleteness(const quint64 types)
+{
+  auto has = [types](const int type) {
+    return (types & (Q_UINT64_C(1) << type)) != 0;
+  };
+  double completeness = 0.0;
+  double valuePerType = 100.0 / (double)completenessTypes();
+  const int counted[] = { ID, TITLE, PLATFORM, COVER, SCREENSHOT, WHEEL, MARQUEE, TEXTURE,
+                          DESCRIPTION, TRIVIA, RELEASEDATE, DEVELOPER, PUBLISHER, TAGS,
+                          FRANCHISES, RATING, PLAYERS, AGES };
+  for(const auto type: counted) {
+    if(has(type)) {
+      completeness += valuePerType;
+    }
+  }
+  const QPair<bool, int> optional[] = {
+    { Skyscraper::config.videos, VIDEO },
+    { Skyscraper::config.manuals, MANUAL },
+    { Skyscraper::config.guides, GUIDES },
+    { Skyscraper::config.cheats, CHEATS },
+    { Skyscraper::config.reviews, REVIEWS },
+    { Skyscraper::config.artbooks, ARTBOOKS },
+    { Skyscraper::config.maps, VGMAPS },
+    { Skyscraper::config.sprites, SPRITES }
+  };
+  for(const auto &type: optional) {
+    if(type.first && has(type.second)) {
+      completeness += valuePerType;
+    }
+  }
+  if(Skyscraper::config.chiptunes && has(CHIPTUNE) && has(CHIPTUNEPATH)) {
+    completeness += valuePerType;
+  }
+  return (int)completeness;
+}
+
 QDataStream &operator>>(QDataStream &in, GameEntry &game)
 {
   in >> game.id >>
@@ -54,6 +54,25 @@ constexpr int CHEATS = 23;
 constexpr int REVIEWS = 24;
 constexpr int ARTBOOKS = 25;
 constexpr int SPRITES = 26;
+// Resource types that are only found in the cache
+constexpr int CHIPTUNEPATH = 28;
+constexpr int DISKSIZE = 29;
+constexpr int COMPLETED = 30;
+constexpr int FAVOURITE = 31;
+constexpr int PLAYED = 32;
+constexpr int TIMESPLAYED = 33;
+constexpr int LASTPLAYED = 34;
+constexpr int FIRSTPLAYED = 35;
+constexpr int TIMEPLAYED = 36;
+constexpr int CANONICALNAME = 37;
+constexpr int CANONICALMAMEID = 38;
+constexpr int CANONICALFILE = 39;
+constexpr int CANONICALPLATFORM = 40;
+constexpr int CANONICALSIZE = 41;
+constexpr int CANONICALCRC = 42;
+constexpr int CANONICALSHA1 = 43;
+constexpr int CANONICALMD5 = 44;
+constexpr int CANONICALCATALOG = 45;
 
 #include <QImage>
 #include <QByteArray>
@@ -77,6 +96,11 @@ public:
   QByteArray serialize() const;
   void resetMedia();
   int getCompleteness() const;
+  static int getCompleteness(const quint64 types);
+  // Media filled in from the resource cache only carries the file name, the
+  // bytes are read by loadMedia() once something actually needs them
+  bool hasMedia(const QString &resource) const;
+  bool loadMedia(const QString &resource);
 
   // The following block is serialized into quickid.xml/db.xml:
   QString id = "";
@@ -197,6 +221,10 @@ public:
   // Pegasus specific metadata for preservation
   QList<QPair<QString, QString> > pSValuePairs;
 
+private:
+  bool mediaFields(const QString &resource, QByteArray *&data, QString *&file);
+  static int completenessTypes();
+
 };
 
 QDataStream &operator<<(QDataStream &out, const GameEntry &game);
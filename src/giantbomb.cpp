@@ -895,18 +895,17 @@ void GiantBomb::getVideo(GameEntry &game)
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      netComm->request(url + "?" + urlPost.chopped(12));
-      q.exec();
-      game.videoData = netComm->getData();
+      const qint64 videoSize = getMediaData(url + "?" + urlPost.chopped(12),
+                                            game.videoData, game.videoFile);
       // Make sure received data is actually a video file
       QByteArray contentType = netComm->getContentType();
       if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
          contentType.contains("video/") &&
-         game.videoData.size() > 4096) {
+         videoSize > 4096) {
         game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
                                            contentType.length() - contentType.indexOf("/") + 1);
       } else {
-        game.videoData = "";
+        discardMediaData(game.videoData, game.videoFile);
         moveOn = false;
       }
       if(moveOn)
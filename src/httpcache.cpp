@@ -0,0 +1,156 @@
+/***************************************************************************
+ *            httpcache.cpp
+ *
+ *  Sat Oct 17 12:00:00 CEST 2026
+ *  Copyright 2025 Risalt @ GitHub
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <cstdio>
+#include <utime.h>
+
+#include "httpcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QDataStream>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QMultiMap>
+
+constexpr quint32 HTTPMAGIC = 0x534b5948; // "SKYH"
+constexpr quint32 HTTPVERSION = 1;
+
+HttpCache::HttpCache(const QString &folder, const qint64 maxSize, const qint64 ttl)
+  : folder(folder), maxSize(maxSize), ttl(ttl)
+{
+}
+
+QString HttpCache::filePath(const QString &url)
+{
+  const QString hash = QString::fromLatin1(
+    QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex());
+  return folder + "/" + hash.left(2) + "/" + hash;
+}
+
+bool HttpCache::lookup(const QString &url, HttpCacheEntry &entry, const bool withData)
+{
+  const QString path = filePath(url);
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&file);
+  quint32 magic = 0, version = 0;
+  in >> magic >> version;
+  if(magic != HTTPMAGIC || version != HTTPVERSION) {
+    return false;
+  }
+  in >> entry.expires >> entry.contentType >> entry.etag >> entry.lastModified;
+  if(withData) {
+    in >> entry.data;
+    // Touched on every use, so eviction goes by last use rather than by age
+    utime(path.toLocal8Bit().constData(), nullptr);
+  }
+  return in.status() == QDataStream::Ok;
+}
+
+void HttpCache::store(const QString &url, HttpCacheEntry &entry, const qint64 maxAge)
+{
+  // Large downloads such as videos would push everything else out
+  if(entry.data.size() > maxSize / 10) {
+    return;
+  }
+  entry.expires = QDateTime::currentSecsSinceEpoch() + (maxAge >= 0?qMin(ttl, maxAge):ttl);
+  const QString path = filePath(url);
+  QMutexLocker locker(&storeMutex);
+  if(totalSize == -1) {
+    totalSize = 0;
+    QDirIterator it(folder, QDir::Files, QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+      it.next();
+      totalSize += it.fileInfo().size();
+    }
+  }
+  QDir().mkpath(QFileInfo(path).path());
+  QFile file(path + ".tmp");
+  if(!file.open(QIODevice::WriteOnly)) {
+    return;
+  }
+  QDataStream out(&file);
+  out << HTTPMAGIC << HTTPVERSION << entry.expires << entry.contentType << entry.etag
+      << entry.lastModified << entry.data;
+  file.close();
+  const qint64 newSize = file.size();
+  const qint64 oldSize = QFileInfo(path).size();
+  // Replaces the old entry in one step, so readers without the lock never see half of it
+  if(std::rename(file.fileName().toLocal8Bit().constData(),
+                 path.toLocal8Bit().constData()) != 0) {
+    file.remove();
+    return;
+  }
+  stored++;
+  totalSize += newSize - oldSize;
+  if(totalSize > maxSize) {
+    evict();
+  }
+}
+
+// Removes the least recently used entries until the cache is down to 90% of its maximum
+// size, which leaves room for a while before the folder has to be listed again.
+void HttpCache::evict()
+{
+  QMultiMap<QDateTime, QFileInfo> entries;
+  QDirIterator it(folder, QDir::Files, QDirIterator::Subdirectories);
+  while(it.hasNext()) {
+    it.next();
+    entries.insert(it.fileInfo().lastModified(), it.fileInfo());
+  }
+  for(auto entry = entries.cbegin();
+      entry != entries.cend() && totalSize > maxSize / 10 * 9; ++entry) {
+    if(QFile::remove(entry.value().absoluteFilePath())) {
+      totalSize -= entry.value().size();
+    }
+  }
+}
+
+qint64 HttpCache::purge()
+{
+  QMutexLocker locker(&storeMutex);
+  qint64 freed = 0;
+  QDirIterator it(folder, QDir::Files, QDirIterator::Subdirectories);
+  while(it.hasNext()) {
+    it.next();
+    const qint64 size = it.fileInfo().size();
+    if(QFile::remove(it.filePath())) {
+      freed += size;
+    }
+  }
+  totalSize = 0;
+  return freed;
+}
+
+void HttpCache::printStats()
+{
+  printf("HTTP cache: \033[1;33m%d\033[0m replies served from disk, \033[1;33m%d\033[0m "
+         "revalidated, \033[1;33m%d\033[0m stored\n\n",
+         hits.load(), revalidated.load(), stored.load());
+}
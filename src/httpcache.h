@@ -0,0 +1,73 @@
+/***************************************************************************
+ *            httpcache.h
+ *
+ *  Sat Oct 17 12:00:00 CEST 2026
+ *  Copyright 2025 Risalt @ GitHub
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QAtomicInt>
+
+struct HttpCacheEntry {
+  QByteArray data;
+  QByteArray contentType;
+  QByteArray etag;
+  QByteArray lastModified;
+  qint64 expires = 0; // Secs since epoch
+};
+
+// Keeps the replies to GET requests on disk, one file per url named after its sha1, so
+// credentials in query strings never end up in the cache. Shared by all threads
+class HttpCache
+{
+public:
+  HttpCache(const QString &folder, const qint64 maxSize, const qint64 ttl);
+
+  // Reads the entry of 'url'. Returns false if there is none
+  bool lookup(const QString &url, HttpCacheEntry &entry, const bool withData = true);
+  // Writes the entry of 'url' with a new expiry, after the ttl or 'maxAge' seconds if that
+  // is sooner, and evicts the least recently used entries if the cache grows past its
+  // maximum size
+  void store(const QString &url, HttpCacheEntry &entry, const qint64 maxAge = -1);
+  // Removes all entries and returns the bytes freed
+  qint64 purge();
+  void printStats();
+
+  QAtomicInt hits = 0;
+  QAtomicInt revalidated = 0;
+  QAtomicInt stored = 0;
+
+private:
+  QString filePath(const QString &url);
+  void evict();
+
+  QString folder;
+  qint64 maxSize;
+  qint64 ttl;
+  qint64 totalSize = -1; // Unknown until the first store
+  QMutex storeMutex;
+};
+
+#endif // HTTPCACHE_H
@@ -49,14 +49,6 @@ Igdb::Igdb(Settings *config,
   headers.append(clientIdHeader);
   headers.append(tokenHeader);
 
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  // 1.2 second request limit set a bit above 0.25 as requested by the folks at IGDB
-  // (4 requests per second=1.0 seconds delay for 4 threads). Don't change! It will
-  // break the module stability.
-  limitTimer.setInterval(1200);
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
-
   baseUrl = "https://api.igdb.com/v4";
 
   searchUrlPre = "https://api.igdb.com/v4";
@@ -86,7 +78,6 @@ void Igdb::getSearchResults(QList<GameEntry> &gameEntries,
                             QString searchName, QString platform)
 {
   // Request list of games but don't allow re-releases ("game.version_parent = null")
-  limiter.exec();
   // netComm->request(baseUrl + "/search/", "fields game.name,game.platforms.name; "
   // "search \"" + searchName + "\"; where game != null & game.version_parent = null;", headers);
   // netComm->request(baseUrl + "/search/", "fields game.name,game.id,game.alternative_names.name,"
@@ -161,7 +152,6 @@ void Igdb::getSearchResults(QList<GameEntry> &gameEntries,
 
 void Igdb::getGameData(GameEntry &game, QStringList &sharedBlobs, GameEntry *cache = nullptr)
 {
-  limiter.exec();
   netComm->request(baseUrl + "/games/",
                    "fields age_ratings.rating,age_ratings.category,total_rating,cover.url,"
                    "game_modes.slug,genres.name,franchises.name,screenshots.url,"
@@ -60,8 +60,6 @@ protected:
   void getVideo(GameEntry &game) override;
 
 private:
-  QTimer limitTimer;
-  QEventLoop limiter;
 
   QList<QPair<QString, QString > > headers;
   QJsonDocument jsonDoc;
@@ -744,11 +744,6 @@ LaunchBox::LaunchBox(Settings *config,
            launchBoxDb.count());
   }
 
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  limitTimer.setInterval(100);
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
-
   fetchOrder.append(ID);
   fetchOrder.append(TITLE);
   fetchOrder.append(PLATFORM);
@@ -859,8 +854,8 @@ void LaunchBox::getTags(GameEntry &game)
 
 void LaunchBox::getCover(GameEntry &game)
 {
-  limiter.exec();
-  netComm->request(baseUrl + launchBoxDb.value(game.id.toInt()).coverFile);
+  const QString url = getMediaUrl(game, COVER);
+  netComm->request(url);
   q.exec();
   QImage image;
   if(netComm->getError() == QNetworkReply::NoError &&
@@ -871,8 +866,8 @@ void LaunchBox::getCover(GameEntry &game)
 
 void LaunchBox::getScreenshot(GameEntry &game)
 {
-  limiter.exec();
-  netComm->request(baseUrl + launchBoxDb.value(game.id.toInt()).screenshotFile);
+  const QString url = getMediaUrl(game, SCREENSHOT);
+  netComm->request(url);
   q.exec();
   QImage image;
   if(netComm->getError() == QNetworkReply::NoError &&
@@ -883,8 +878,8 @@ void LaunchBox::getScreenshot(GameEntry &game)
 
 void LaunchBox::getWheel(GameEntry &game)
 {
-  limiter.exec();
-  netComm->request(baseUrl + launchBoxDb.value(game.id.toInt()).wheelFile);
+  const QString url = getMediaUrl(game, WHEEL);
+  netComm->request(url);
   q.exec();
   QImage image;
   if(netComm->getError() == QNetworkReply::NoError &&
@@ -895,8 +890,8 @@ void LaunchBox::getWheel(GameEntry &game)
 
 void LaunchBox::getMarquee(GameEntry &game)
 {
-  limiter.exec();
-  netComm->request(baseUrl + launchBoxDb.value(game.id.toInt()).marqueeFile);
+  const QString url = getMediaUrl(game, MARQUEE);
+  netComm->request(url);
   q.exec();
   QImage image;
   if(netComm->getError() == QNetworkReply::NoError &&
@@ -907,8 +902,8 @@ void LaunchBox::getMarquee(GameEntry &game)
 
 void LaunchBox::getTexture(GameEntry &game)
 {
-  limiter.exec();
-  netComm->request(baseUrl + launchBoxDb.value(game.id.toInt()).textureFile);
+  const QString url = getMediaUrl(game, TEXTURE);
+  netComm->request(url);
   q.exec();
   QImage image;
   if(netComm->getError() == QNetworkReply::NoError &&
@@ -919,7 +914,7 @@ void LaunchBox::getTexture(GameEntry &game)
 
 void LaunchBox::getVideo(GameEntry &game)
 {
-  QString videoUrl = launchBoxDb.value(game.id.toInt()).videoFile;
+  QString videoUrl = getMediaUrl(game, VIDEO);
   //printf("Downloading video '%s'.\n", videoUrl.toStdString().c_str());
   if(videoUrl.contains("youtube") || videoUrl.contains("youtu.be")) {
     getOnlineVideo(videoUrl, game);
@@ -927,19 +922,16 @@ void LaunchBox::getVideo(GameEntry &game)
   else if(!videoUrl.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
-      netComm->request(videoUrl);
-      q.exec();
-      game.videoData = netComm->getData();
+      const qint64 videoSize = getMediaData(videoUrl, game.videoData, game.videoFile);
       // Make sure received data is actually a video file
       QByteArray contentType = netComm->getContentType();
       if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
          contentType.contains("video/") &&
-         game.videoData.size() > 4096) {
+         videoSize > 4096) {
         game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
                                            contentType.length() - contentType.indexOf("/") + 1);
       } else {
-        game.videoData = "";
+        discardMediaData(game.videoData, game.videoFile);
         moveOn = false;
       }
       if(moveOn)
@@ -948,6 +940,41 @@ void LaunchBox::getVideo(GameEntry &game)
   }
 }
 
+// The url the media getters above request for 'type'.
+QString LaunchBox::getMediaUrl(GameEntry &game, const int type)
+{
+  const GameEntry &entry = launchBoxDb.value(game.id.toInt());
+  switch(type) {
+  case COVER:
+    return baseUrl + entry.coverFile;
+  case SCREENSHOT:
+    return baseUrl + entry.screenshotFile;
+  case WHEEL:
+    return baseUrl + entry.wheelFile;
+  case MARQUEE:
+    return baseUrl + entry.marqueeFile;
+  case TEXTURE:
+    return baseUrl + entry.textureFile;
+  case VIDEO:
+    return entry.videoFile;
+  default:
+    return QString();
+  }
+}
+
+QStringList LaunchBox::getMediaUrls(GameEntry &game, const QList<int> &types)
+{
+  QStringList urls;
+  for(const auto type: std::as_const(types)) {
+    const QString url = getMediaUrl(game, type);
+    // Games without that media and youtube videos are left to the getters
+    if(url != baseUrl && !url.contains("youtube") && !url.contains("youtu.be")) {
+      urls.append(url);
+    }
+  }
+  return urls;
+}
+
 void LaunchBox::loadMaps()
 {
   loadConfig("launchbox.json", "code", "query");
@@ -27,11 +27,9 @@
 
 #include <QMap>
 #include <QList>
-#include <QTimer>
 #include <QString>
 #include <QStringList>
 #include <QMultiMap>
-#include <QEventLoop>
 
 #include "abstractscraper.h"
 
@@ -90,12 +88,12 @@ protected:
   void getMarquee(GameEntry &game) override;
   void getTexture(GameEntry &game) override;
   void getVideo(GameEntry &game) override;
+  QStringList getMediaUrls(GameEntry &game, const QList<int> &types) override;
 
 private:
   void loadMaps();
+  QString getMediaUrl(GameEntry &game, const int type);
 
-  QTimer limitTimer;
-  QEventLoop limiter;
 
   QMap<int, GameEntry> launchBoxDb;
   QMultiMap<QString, QPair<int, QString>> searchNameToId;
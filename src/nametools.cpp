@@ -453,10 +453,9 @@ QString NameTools::getUniqueNotes(const QString &notes, QChar delim)
   return uniqueNotes;
 }
 
-QString NameTools::getCacheId(const QFileInfo &info)
+// Whether the cache id of a rom is the checksum of its contents rather than of its name
+bool NameTools::cacheIdFromData(const QFileInfo &info)
 {
-  QCryptographicHash cacheId(QCryptographicHash::Sha1);
-
   QString suffix = info.suffix().toLower();
   // Use checksum of filename if file is a script or an "unstable" compressed filetype
   bool cacheIdFromData = true;
@@ -479,11 +478,25 @@ QString NameTools::getCacheId(const QFileInfo &info)
   if(info.size() < 100) {
     cacheIdFromData = false;
   }
-  if(cacheIdFromData) {
+  return cacheIdFromData;
+}
+
+QString NameTools::getCacheId(const QFileInfo &info)
+{
+  QCryptographicHash cacheId(QCryptographicHash::Sha1);
+
+  if(cacheIdFromData(info)) {
     QFile romFile(info.absoluteFilePath());
     if(romFile.open(QIODevice::ReadOnly)) {
-      while(!romFile.atEnd()) {
-        cacheId.addData(romFile.read(1024));
+      // Hashed straight from the page cache when the file can be mapped
+      uchar *data = romFile.map(0, romFile.size());
+      if(data != nullptr) {
+        cacheId.addData(reinterpret_cast<const char *>(data), romFile.size());
+        romFile.unmap(data);
+      } else {
+        while(!romFile.atEnd()) {
+          cacheId.addData(romFile.read(1024 * 1024));
+        }
       }
       romFile.close();
     } else {
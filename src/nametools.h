@@ -56,6 +56,7 @@ public:
   static QString getParNotes(QString baseName);
   static QString getUniqueNotes(const QString &notes, QChar delim);
   static QString getCacheId(const QFileInfo &info);
+  static bool cacheIdFromData(const QFileInfo &info);
   static QString getNameFromTemplate(const GameEntry &game, const QString &nameTemplate);
   static QString removeArticle(const QString &baseName, const QString &spaceChar = " ");
   static QString moveArticle(const QString &baseName, const bool &toFront);
@@ -28,28 +28,71 @@
 
 #include <QUrl>
 #include <QNetworkRequest>
+#include <QEventLoop>
+#include <QDateTime>
+#include <QDir>
 
 constexpr int MAXSIZE = 100*1024*1024;
 
+// Tells apart downloads with the same content until the cache has moved them into place
+static QAtomicInt downloadCount;
+
 NetComm::NetComm(QSharedPointer<NetManager> manager)
-  : manager(manager)
+  : manager(manager), downloadHash(QCryptographicHash::Sha1)
 {
   requestTimer.setSingleShot(true);
   requestTimer.setInterval(30000);
   connect(&requestTimer, &QTimer::timeout, this, &NetComm::requestTimeout);
 }
 
-void NetComm::request(QString query, QString postData, QList<QPair<QString, QString> > headers, QByteArray operation)
+void NetComm::request(QString query, QString postData, QList<QPair<QString, QString> > headers, QByteArray operation,
+                      const bool httpCacheable)
 {
+  if(postData.isNull() && headers.isEmpty() && operation.isEmpty() &&
+     prefetched.contains(query)) {
+    const PrefetchedReply prefetchedReply = prefetched.take(query);
+    data = prefetchedReply.data;
+    error = prefetchedReply.error;
+    contentType = prefetchedReply.contentType;
+    redirUrl = prefetchedReply.redirUrl;
+    // Queued, as the caller only starts waiting for the signal after this returns
+    QTimer::singleShot(0, this, [this]() { emit dataReady(); });
+    return;
+  }
+
+  // Only plain GET requests are cached, the others usually change something or carry
+  // the query in the body. Extra headers mostly carry credentials, so the reply belongs
+  // to the account rather than to the url
+  httpCache = manager->getHttpCache();
+  cacheUrl = (httpCacheable && !httpCache.isNull() && postData.isNull() && operation.isEmpty() &&
+              headers.isEmpty()?query:QString());
+  revalidating = false;
+  if(!cacheUrl.isEmpty() && httpCache->lookup(cacheUrl, cachedEntry)) {
+    if(cachedEntry.expires > QDateTime::currentSecsSinceEpoch()) {
+      httpCache->hits++;
+      data = cachedEntry.data;
+      error = QNetworkReply::NoError;
+      contentType = cachedEntry.contentType;
+      redirUrl.clear();
+      QTimer::singleShot(0, this, [this]() { emit dataReady(); });
+      return;
+    }
+    revalidating = !cachedEntry.etag.isEmpty() || !cachedEntry.lastModified.isEmpty();
+  }
+
   QUrl url(query);
   if(Skyscraper::config.verbosity >= 1) {
     qDebug() << url;
   }
-  QNetworkRequest request(url);
-/*  request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
-  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);*/
-  request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0 (X11; Ubuntu; Linux x86_64; rv:74.0) Gecko/20100101 Firefox/74.0");
-  request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+  QNetworkRequest request = makeRequest(url);
+  if(revalidating) {
+    if(!cachedEntry.etag.isEmpty()) {
+      request.setRawHeader("If-None-Match", cachedEntry.etag);
+    }
+    if(!cachedEntry.lastModified.isEmpty()) {
+      request.setRawHeader("If-Modified-Since", cachedEntry.lastModified);
+    }
+  }
 
   if(!headers.isEmpty()) {
     for(const auto &header: std::as_const(headers)) {
@@ -60,6 +103,9 @@ void NetComm::request(QString query, QString postData, QList<QPair<QString, QStr
     }
   }
 
+  // Waits here while other threads use up the allowance for this host
+  host = url.host();
+  manager->acquireHost(host);
   if(operation.isEmpty()) {
     if(postData.isNull()) {
       reply = manager->getRequest(request);
@@ -76,14 +122,261 @@ void NetComm::request(QString query, QString postData, QList<QPair<QString, QStr
   requestTimer.start();
 }
 
+void NetComm::requestUncached(const QString &query)
+{
+  request(query, QString(), QList<QPair<QString, QString> >(), QByteArray(), false);
+}
+
+void NetComm::requestToFile(const QString &query, const QString &folder)
+{
+  data.clear();
+  contentType.clear();
+  redirUrl.clear();
+  downloadFile.clear();
+  downloadFolder = folder;
+  // Large media are neither prefetched nor kept in the HTTP cache
+  cacheUrl.clear();
+  revalidating = false;
+  QDir().mkpath(folder);
+  download.reset(new QTemporaryFile(folder + "/XXXXXX.part"));
+  if(!download->open()) {
+    printf("\033[1;31mCouldn't create download file in '%s', please check permissions.\033[0m\n",
+           folder.toStdString().c_str());
+    download.reset();
+    error = QNetworkReply::UnknownContentError;
+    QTimer::singleShot(0, this, [this]() { emit dataReady(); });
+    return;
+  }
+  downloadHash.reset();
+  error = QNetworkReply::NoError;
+
+  QUrl url(query);
+  if(Skyscraper::config.verbosity >= 1) {
+    qDebug() << url;
+  }
+  host = url.host();
+  manager->acquireHost(host);
+  reply = manager->getRequest(makeRequest(url));
+  connect(reply, &QNetworkReply::readyRead, this, &NetComm::writeChunk);
+  connect(reply, &QNetworkReply::finished, this, &NetComm::replyReady);
+  connect(reply, &QNetworkReply::downloadProgress, this, &NetComm::dataDownloaded);
+  requestTimer.start();
+}
+
+void NetComm::writeChunk()
+{
+  const QByteArray chunk = reply->readAll();
+  downloadHash.addData(chunk);
+  if(download->write(chunk) != chunk.size()) {
+    printf("\033[1;31mCouldn't write to download file '%s', cancelling network request...\033[0m\n",
+           download->fileName().toStdString().c_str());
+    error = QNetworkReply::UnknownContentError;
+    reply->abort();
+    return;
+  }
+  // Big files take longer than the timeout, so it only fires when the data stalls
+  requestTimer.start();
+}
+
+// Gives a complete download its final name, which starts with the sha1 of its content so
+// the cache doesn't have to read it again to dedup it. Failed downloads are removed.
+void NetComm::finishDownload()
+{
+  const QByteArray chunk = reply->readAll();
+  downloadHash.addData(chunk);
+  if(download->write(chunk) != chunk.size()) {
+    error = QNetworkReply::UnknownContentError;
+  }
+  if(error == QNetworkReply::NoError && download->size() > 0 && download->flush()) {
+    const QString fileName = downloadFolder + "/" + downloadHash.result().toHex() + "-" +
+                             QString::number(downloadCount.fetchAndAddRelaxed(1));
+    download->close();
+    download->setAutoRemove(false);
+    if(QFile::rename(download->fileName(), fileName)) {
+      downloadFile = fileName;
+    } else {
+      QFile::remove(download->fileName());
+    }
+  }
+  download.reset();
+}
+
+QString NetComm::getFile()
+{
+  return downloadFile;
+}
+
+QNetworkRequest NetComm::makeRequest(const QUrl &url)
+{
+  QNetworkRequest request(url);
+/*  request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+  request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);*/
+  request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0 (X11; Ubuntu; Linux x86_64; rv:74.0) Gecko/20100101 Firefox/74.0");
+  request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+  return request;
+}
+
+void NetComm::prefetch(const QStringList &urls)
+{
+  prefetched.clear();
+  httpCache = manager->getHttpCache();
+  QStringList waiting;
+  for(const auto &url: urls) {
+    if(!url.isEmpty() && !waiting.contains(url)) {
+      // Fresh copies in the HTTP cache are picked up by request() itself
+      HttpCacheEntry entry;
+      if(!httpCache.isNull() && httpCache->lookup(url, entry, false) &&
+         entry.expires > QDateTime::currentSecsSinceEpoch()) {
+        continue;
+      }
+      waiting.append(url);
+    }
+  }
+  if(waiting.isEmpty()) {
+    return;
+  }
+
+  QEventLoop loop;
+  QTimer retryTimer;
+  retryTimer.setSingleShot(true);
+  connect(&retryTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+  QList<QNetworkReply *> running;
+
+  while(!waiting.isEmpty() || !running.isEmpty()) {
+    while(!waiting.isEmpty()) {
+      const QString url = waiting.first();
+      const QString urlHost = QUrl(url).host();
+      // Slots are given back by the replies finishing on this thread, so only wait for
+      // one when none of ours are in flight
+      if(running.isEmpty()) {
+        manager->acquireHost(urlHost);
+      } else if(!manager->tryAcquireHost(urlHost)) {
+        break;
+      }
+      waiting.removeFirst();
+      if(Skyscraper::config.verbosity >= 1) {
+        qDebug() << QUrl(url);
+      }
+      QNetworkReply *batchReply = manager->getRequest(makeRequest(QUrl(url)));
+      running.append(batchReply);
+      // Every reply gets the full timeout from when it is sent, as later ones may have
+      // waited for a slot. Owned by the reply, so it goes away with it
+      QTimer *replyTimer = new QTimer(batchReply);
+      replyTimer->setSingleShot(true);
+      connect(replyTimer, &QTimer::timeout, batchReply, [batchReply]() {
+        printf("\033[1;33mRequest timed out, server might be busy / overloaded...\033[0m\n");
+        // Aborting finishes the reply, which removes it from 'running'
+        batchReply->abort();
+      });
+      replyTimer->start(requestTimer.interval());
+      connect(batchReply, &QNetworkReply::finished, &loop,
+              [this, &loop, &running, batchReply, url, urlHost]() {
+        PrefetchedReply &prefetchedReply = prefetched[url];
+        prefetchedReply.data = batchReply->readAll();
+        prefetchedReply.error = batchReply->error();
+        prefetchedReply.contentType = batchReply->rawHeader("Content-Type");
+        prefetchedReply.redirUrl = batchReply->rawHeader("Location");
+        if(!httpCache.isNull()) {
+          storeReply(url, batchReply, prefetchedReply.data);
+        }
+        running.removeOne(batchReply);
+        batchReply->deleteLater();
+        manager->releaseHost(urlHost);
+        loop.quit();
+      });
+      connect(batchReply, &QNetworkReply::downloadProgress, &loop,
+              [batchReply, replyTimer](qint64 bytesReceived, qint64) {
+        // Like request(), a download that is still receiving data hasn't timed out
+        replyTimer->start();
+        if(bytesReceived > MAXSIZE) {
+          printf("Retrieved data size exceeded maximum of 100 MB, cancelling network request...\n");
+          batchReply->abort();
+        }
+      });
+    }
+    if(!running.isEmpty()) {
+      if(!waiting.isEmpty()) {
+        // Tokens refill with time, not only when our replies finish
+        retryTimer.start(100);
+      }
+      loop.exec();
+    }
+  }
+}
+
+// Keeps a successful reply in the HTTP cache, as long as its Cache-Control header allows
+// it. 'no-store' and 'private' replies are not kept. 'max-age' shortens the ttl, and
+// 'no-cache' or a 'max-age' of 0 keeps the reply only to revalidate it next time
+void NetComm::storeReply(const QString &url, QNetworkReply *storedReply, const QByteArray &replyData)
+{
+  if(storedReply->error() != QNetworkReply::NoError || replyData.isEmpty() ||
+     storedReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 200) {
+    return;
+  }
+  HttpCacheEntry entry;
+  entry.data = replyData;
+  entry.contentType = storedReply->rawHeader("Content-Type");
+  entry.etag = storedReply->rawHeader("ETag");
+  entry.lastModified = storedReply->rawHeader("Last-Modified");
+  qint64 maxAge = -1;
+  const QList<QByteArray> directives = storedReply->rawHeader("Cache-Control").toLower().split(',');
+  for(const auto &directive: directives) {
+    const QByteArray name = directive.trimmed();
+    if(name == "no-store" || name == "private") {
+      return;
+    } else if(name == "no-cache") {
+      maxAge = 0;
+    } else if(name.startsWith("max-age=")) {
+      bool ok = false;
+      const qint64 seconds = name.mid(8).toLongLong(&ok);
+      if(ok && (maxAge == -1 || seconds < maxAge)) {
+        maxAge = qMax(Q_INT64_C(0), seconds);
+      }
+    }
+  }
+  if(maxAge == 0 && entry.etag.isEmpty() && entry.lastModified.isEmpty()) {
+    // Could never be used without downloading it again
+    return;
+  }
+  httpCache->store(url, entry, maxAge);
+}
+
+bool NetComm::isPrefetched(const QString &url)
+{
+  return prefetched.contains(url);
+}
+
+void NetComm::clearPrefetched()
+{
+  prefetched.clear();
+}
+
 void NetComm::replyReady()
 {
   requestTimer.stop();
-  data = reply->readAll();
-  error = reply->error();
-  contentType = reply->rawHeader("Content-Type");;
+  if(error == QNetworkReply::NoError || download.isNull()) {
+    error = reply->error();
+  }
+  contentType = reply->rawHeader("Content-Type");
   redirUrl = reply->rawHeader("Location");
+  if(!download.isNull()) {
+    finishDownload();
+  } else {
+    data = reply->readAll();
+  }
+  if(revalidating &&
+     reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+    // Unchanged on the server, so the cached copy is good for another ttl
+    httpCache->revalidated++;
+    data = cachedEntry.data;
+    contentType = cachedEntry.contentType;
+    httpCache->store(cacheUrl, cachedEntry);
+  } else if(!cacheUrl.isEmpty()) {
+    storeReply(cacheUrl, reply, data);
+  }
+  cachedEntry = HttpCacheEntry();
   reply->deleteLater();
+  manager->releaseHost(host);
   emit dataReady();
 }
 
@@ -27,9 +27,21 @@
 #define NETCOMM_H
 
 #include "netmanager.h"
+#include "httpcache.h"
 
 #include <QNetworkReply>
+#include <QNetworkRequest>
 #include <QTimer>
+#include <QHash>
+#include <QTemporaryFile>
+#include <QCryptographicHash>
+
+struct PrefetchedReply {
+  QByteArray data;
+  QNetworkReply::NetworkError error = QNetworkReply::NoError;
+  QByteArray contentType;
+  QByteArray redirUrl;
+};
 
 class NetComm : public QObject
 {
@@ -39,14 +51,29 @@ public:
   NetComm(QSharedPointer<NetManager> manager);
   void request(QString query, QString postData = QString(), QList<QPair<QString,
                QString> > headers = QList<QPair<QString, QString> >(),
-               QByteArray operation = "");
+               QByteArray operation = "", const bool httpCacheable = true);
+  // Like request(), but the reply never comes from or goes into the HTTP cache. For replies
+  // that report the account or its remaining quota, which a cached copy would get wrong
+  void requestUncached(const QString &query);
   QByteArray getData();
   QNetworkReply::NetworkError getError(const int &verbosity = 0);
   QByteArray getContentType();
   QByteArray getRedirUrl();
 
+  // Streams the reply of 'query' into a file in 'folder' instead of memory, getData() stays
+  // empty. The complete file is named after the sha1 of its content, see getFile()
+  void requestToFile(const QString &query, const QString &folder);
+  QString getFile();
+
+  // Downloads all 'urls' at the same time and waits for them. A later request() for one
+  // of them returns the kept reply instead of going to the network
+  void prefetch(const QStringList &urls);
+  bool isPrefetched(const QString &url);
+  void clearPrefetched();
+
 private slots:
   void replyReady();
+  void writeChunk();
   void dataDownloaded(qint64 bytesReceived, qint64);
   void requestTimeout();
 
@@ -54,12 +81,26 @@ signals:
   void dataReady();
 
 private:
+  QNetworkRequest makeRequest(const QUrl &url);
+  void storeReply(const QString &url, QNetworkReply *storedReply, const QByteArray &replyData);
+  void finishDownload();
+
   QSharedPointer<NetManager> manager;
   QTimer requestTimer;
   QByteArray data;
   QNetworkReply::NetworkError error;
   QByteArray contentType;
   QByteArray redirUrl;
+  QString host;
+  QHash<QString, PrefetchedReply> prefetched;
+  QSharedPointer<HttpCache> httpCache;
+  QString cacheUrl; // Empty if the current request bypasses the HTTP cache
+  HttpCacheEntry cachedEntry;
+  bool revalidating = false;
+  QScopedPointer<QTemporaryFile> download; // Only set while a requestToFile() is running
+  QCryptographicHash downloadHash;
+  QString downloadFolder;
+  QString downloadFile;
   QNetworkReply *reply;
 };
 
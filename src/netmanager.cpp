@@ -54,3 +54,104 @@ QNetworkReply *NetManager::customRequest(const QNetworkRequest &request, const Q
   QMutexLocker locker(&requestMutex);
   return sendCustomRequest(request, operation, data);
 }
+
+void NetManager::setHttpCache(QSharedPointer<HttpCache> cache)
+{
+  QMutexLocker locker(&requestMutex);
+  httpCache = cache;
+}
+
+QSharedPointer<HttpCache> NetManager::getHttpCache()
+{
+  QMutexLocker locker(&requestMutex);
+  return httpCache;
+}
+
+void NetManager::setHostLimit(const QString &host, const double rate, const int burst,
+                              const int inFlightMax)
+{
+  QMutexLocker locker(&limitMutex);
+  if(hostLimits.contains(host)) {
+    return;
+  }
+  HostLimit &limit = hostLimits[host];
+  limit.rate = rate;
+  limit.burst = qMax(1, burst);
+  limit.inFlightMax = inFlightMax;
+  limit.tokens = limit.burst;
+  limit.refillTimer.start();
+}
+
+void NetManager::acquireHost(const QString &host)
+{
+  QMutexLocker locker(&limitMutex);
+  while(true) {
+    // Looked up on every pass, as the hash may change while waiting
+    HostLimit *limit = findLimit(host);
+    if(limit == nullptr) {
+      return;
+    }
+    const long waitMsecs = takeSlot(*limit);
+    if(waitMsecs == 0) {
+      return;
+    } else if(waitMsecs < 0) {
+      // Woken up by releaseHost()
+      limitCondition.wait(&limitMutex);
+    } else {
+      limitCondition.wait(&limitMutex, (unsigned long)waitMsecs);
+    }
+  }
+}
+
+bool NetManager::tryAcquireHost(const QString &host)
+{
+  QMutexLocker locker(&limitMutex);
+  HostLimit *limit = findLimit(host);
+  return limit == nullptr || takeSlot(*limit) == 0;
+}
+
+void NetManager::releaseHost(const QString &host)
+{
+  QMutexLocker locker(&limitMutex);
+  HostLimit *limit = findLimit(host);
+  if(limit != nullptr && limit->inFlight > 0) {
+    limit->inFlight--;
+    limitCondition.wakeAll();
+  }
+}
+
+// Services often serve media from other subdomains than their api, so a limit set for
+// 'screenscraper.fr' also covers 'neoclone.screenscraper.fr'
+HostLimit *NetManager::findLimit(QString host)
+{
+  while(!host.isEmpty()) {
+    auto it = hostLimits.find(host);
+    if(it != hostLimits.end()) {
+      return &it.value();
+    }
+    const int dot = host.indexOf('.');
+    host = (dot == -1?QString():host.mid(dot + 1));
+  }
+  return nullptr;
+}
+
+// Takes a token and an in-flight slot. Returns 0 if they were taken, otherwise the msecs
+// until the next token, or -1 if only a finished request can free a slot
+long NetManager::takeSlot(HostLimit &limit)
+{
+  if(limit.rate > 0.0) {
+    limit.tokens = qMin((double)limit.burst,
+                        limit.tokens + limit.refillTimer.restart() * limit.rate / 1000.0);
+    if(limit.tokens < 1.0) {
+      return (long)((1.0 - limit.tokens) * 1000.0 / limit.rate) + 1;
+    }
+  }
+  if(limit.inFlightMax > 0 && limit.inFlight >= limit.inFlightMax) {
+    return -1;
+  }
+  if(limit.rate > 0.0) {
+    limit.tokens -= 1.0;
+  }
+  limit.inFlight++;
+  return 0;
+}
@@ -29,6 +29,22 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSharedPointer>
+
+#include "httpcache.h"
+
+// Token bucket shared by every thread sending requests to one host
+struct HostLimit {
+  double rate = 0.0; // Requests per second, 0 means no rate limit
+  int burst = 1;
+  int inFlightMax = 0; // 0 means no limit on concurrent requests
+  double tokens = 1.0;
+  int inFlight = 0;
+  QElapsedTimer refillTimer;
+};
 
 class NetManager : public QNetworkAccessManager
 {
@@ -41,7 +57,27 @@ public:
   QNetworkReply *deleteRequest(const QNetworkRequest &request);
   QNetworkReply *customRequest(const QNetworkRequest &request, const QByteArray &data, QByteArray operation);
 
+  // Limits the requests to 'host' and its subdomains from all threads together
+  void setHostLimit(const QString &host, const double rate, const int burst,
+                    const int inFlightMax);
+  // Blocks the calling thread until a request to 'host' is allowed. Every call must be
+  // paired with a releaseHost() once the reply has finished
+  void acquireHost(const QString &host);
+  // Like acquireHost() but returns false instead of waiting
+  bool tryAcquireHost(const QString &host);
+  void releaseHost(const QString &host);
+
+  void setHttpCache(QSharedPointer<HttpCache> cache);
+  QSharedPointer<HttpCache> getHttpCache();
+
 private:
+  HostLimit *findLimit(QString host);
+  long takeSlot(HostLimit &limit);
+
   QMutex requestMutex;
+  QMutex limitMutex;
+  QWaitCondition limitCondition;
+  QHash<QString, HostLimit> hostLimits;
+  QSharedPointer<HttpCache> httpCache;
 };
 #endif // NETMANAGER_H
@@ -53,11 +53,6 @@ OpenRetro::OpenRetro(Settings *config,
     return;
   }
 
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  limitTimer.setInterval(500); // OpenRetro seems to get tired after a few minutes of high-speed scraping...
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
-
   baseUrl = "https://openretro.org";
 
   searchUrlPre = "https://openretro.org";
@@ -159,7 +154,6 @@ void OpenRetro::getSearchResults(QList<GameEntry> &gameEntries,
     }
     lookupReq = lookupReq + "/browse/" + platformId + "?q=" + finalSearchName + searchUrlPost;
   }
-  limiter.exec();
   netComm->request(lookupReq);
   q.exec();
 
@@ -167,7 +161,6 @@ void OpenRetro::getSearchResults(QList<GameEntry> &gameEntries,
 
   while(!netComm->getRedirUrl().isEmpty()) {
     game.url = netComm->getRedirUrl();
-    limiter.exec();
     netComm->request(game.url);
     q.exec();
   }
@@ -243,7 +236,6 @@ void OpenRetro::getSearchResults(QList<GameEntry> &gameEntries,
 void OpenRetro::getGameData(GameEntry &game, QStringList &sharedBlobs, GameEntry *cache = nullptr)
 {
   if(!game.url.isEmpty()) {
-    limiter.exec();
     netComm->request(game.url);
     q.exec();
     data = netComm->getData();
@@ -315,7 +307,6 @@ void OpenRetro::getTags(GameEntry &game)
 
 void OpenRetro::getManual(GameEntry &game)
 {
-  limiter.exec();
   netComm->request(game.url + "/docs");
   q.exec();
   data = netComm->getData();
@@ -341,12 +332,11 @@ void OpenRetro::getManual(GameEntry &game)
   }
   if(!pageSize.isEmpty() && !docId.isEmpty()) {
     QString manualUrl = baseUrl + "/image/" + docId + "?s=" + pageSize + "&f=pdf";
-    limiter.exec();
-    netComm->request(manualUrl);
-    q.exec();
+    getMediaData(manualUrl, game.manualData, game.manualFile);
     if(netComm->getError() == QNetworkReply::NoError) {
-      game.manualData = netComm->getData();
       game.manualFormat = "pdf";
+    } else {
+      discardMediaData(game.manualData, game.manualFile);
     }
   }
 }
@@ -354,7 +344,6 @@ void OpenRetro::getManual(GameEntry &game)
 void OpenRetro::getRating(GameEntry &game)
 {
   game.url.chop(5); // remove trailing '/edit'
-  limiter.exec();
   netComm->request(game.url);
   q.exec();
   data = netComm->getData();
@@ -422,7 +411,6 @@ void OpenRetro::getScreenshot(GameEntry &game)
   if(screenshotUrl.left(4) != "http") {
     screenshotUrl.prepend(baseUrl + (screenshotUrl.left(1) == "/"?"":"/"));
   }
-  limiter.exec();
   netComm->request(screenshotUrl);
   q.exec();
   QImage image;
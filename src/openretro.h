@@ -27,8 +27,6 @@
 #define OPENRETRO_H
 
 #include <QMap>
-#include <QTimer>
-#include <QEventLoop>
 
 #include "abstractscraper.h"
 
@@ -54,8 +52,6 @@ protected:
   void getManual(GameEntry &game) override;
 
 private:
-  QTimer limitTimer;
-  QEventLoop limiter;
 
   QString platformId;
   bool restrictSearch = false;
@@ -276,18 +276,16 @@ void RawG::getVideo(GameEntry &game)
     QString url = jsonTrailer["data"].toObject()["480"].toString();
     if(!url.isEmpty()) {
       printf("Waiting to get trailer data...\n");
-      netComm->request(url);
-      q.exec();
-      game.videoData = netComm->getData();
+      const qint64 videoSize = getMediaData(url, game.videoData, game.videoFile);
       // Make sure received data is actually a video file
       QByteArray contentType = netComm->getContentType();
       if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-         contentType.contains("video/") && game.videoData.size() > 4096) {
+         contentType.contains("video/") && videoSize > 4096) {
         game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
                                            contentType.length() - contentType.indexOf("/") + 1);
         return;
       } else {
-        game.videoData = "";
+        discardMediaData(game.videoData, game.videoFile);
       }
     }
     jsonTrailers.removeFirst();
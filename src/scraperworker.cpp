@@ -26,6 +26,7 @@
 #include <iostream>
 
 #include <QTimer>
+#include <QtConcurrent>
 
 #include "scraperworker.h"
 #include "strtools.h"
@@ -67,8 +68,10 @@ ScraperWorker::ScraperWorker(QSharedPointer<Queue> queue,
                              QSharedPointer<Cache> cache,
                              QSharedPointer<NetManager> manager,
                              Settings config,
-                             QString threadId)
-  : config(config), cache(cache), manager(manager), queue(queue), threadId(threadId)
+                             QString threadId,
+                             QSharedPointer<ScraperStages> stages)
+  : config(config), cache(cache), manager(manager), queue(queue), stages(stages),
+    threadId(threadId)
 {
   NameTool = new NameTools(threadId);
 }
@@ -78,6 +81,29 @@ ScraperWorker::~ScraperWorker()
   delete NameTool;
 }
 
+void ScraperStages::add(const int stage, const qint64 elapsed)
+{
+  msecs[stage] += elapsed;
+  roms[stage]++;
+}
+
+// Times are summed over all threads, so they can exceed the completion time of the run
+void ScraperStages::print(const bool pipelined)
+{
+  const QStringList names = {"Hash", "Search", "Fetch", "Commit"};
+  printf("Time spent per stage (summed over threads):\n");
+  for(int stage = 0; stage < STAGECOUNT; ++stage) {
+    printf("  %-8s\033[1;33m%.1f\033[0m secs over %d roms\n",
+           (names.at(stage) + ":").toStdString().c_str(),
+           (double)msecs[stage].load() / 1000.0, roms[stage].load());
+  }
+  if(pipelined) {
+    printf("Scraping threads waiting on a full commit stage: \033[1;33m%.1f\033[0m secs\n",
+           (double)waitMsecs.load() / 1000.0);
+  }
+  printf("\n");
+}
+
 // Instantiates the actual scraper and processes files from the list of files.
 // Protected by mutex as there can be several scraper workers in parallel.
 void ScraperWorker::run()
@@ -149,6 +175,13 @@ void ScraperWorker::run()
     scraper = new AbstractScraper(&config, manager, threadId, NameTool);
   }
 
+  // The limit is shared by all threads, so the service sees one rate however many
+  // threads are scraping. Only the first worker's call registers it
+  if((config.requestRate > 0.0 || config.requestsInFlight > 0) && !scraper->getHost().isEmpty()) {
+    manager->setHostLimit(scraper->getHost(), config.requestRate, config.requestBurst,
+                          config.requestsInFlight);
+  }
+
   QString error = "\033[1;33m(T" + threadId + ")\033[0m ";
   if(limitReached(error)) {
     printf(error.toStdString().c_str()); fflush(stdout);
@@ -172,11 +205,14 @@ void ScraperWorker::run()
     QString output = "\033[1;33m(T" + threadId + ")\033[0m ";
     QString lowMatch = "";
     QString debug = "";
+    QElapsedTimer stageTimer;
+    stageTimer.start();
     QString cacheId = cache->getQuickId(info);
     if(cacheId.isEmpty()) {
       cacheId = NameTools::getCacheId(info);
       cache->addQuickId(info, cacheId);
     }
+    stages->add(STAGEHASH, stageTimer.restart());
 
     // Create the game entry we use for the rest of the process
     GameEntry game, game2;
@@ -210,10 +246,12 @@ void ScraperWorker::run()
           action = "skip";
         }
       } else if(!config.refresh && hasOwnEntries && config.getMissingResources) {
-        cachedGame.cacheId = cacheId;
-        cache->fillBlanks(cachedGame, config.scraper);
-        if(cachedGame.getCompleteness() < 99.0) {
-            action = "update";
+        // The cached types tell whether anything is missing, the entry itself is only
+        // needed when it is going to be updated
+        if(GameEntry::getCompleteness(cache->typeMask(cacheId, config.scraper)) < 99.0) {
+          cachedGame.cacheId = cacheId;
+          cache->fillBlanks(cachedGame, config.scraper);
+          action = "update";
         }
       }
       if(action == "nothing") {
@@ -538,6 +576,8 @@ void ScraperWorker::run()
       }
     }
 
+    stages->add(STAGESEARCH, stageTimer.restart());
+
     QStringList sharedBlobs = {};
     if(config.scraper != "cache") {
       if(cache->hasEntriesOfType(cacheId, "video")) {
@@ -572,200 +612,283 @@ void ScraperWorker::run()
       }
     }
 
-    if(!config.pretend && config.scraper == "cache") {
-      // Process all artwork
-      compositor.saveAll(game, info.completeBaseName());
-      // Copy or symlink videos as requested
-      if(config.videos &&
-         !game.videoFormat.isEmpty() &&
-         !game.videoFile.isEmpty() &&
-         QFile::exists(game.videoFile)) {
-        QString videoDst = config.videosFolder + "/" + info.completeBaseName() +
-                           "." + game.videoFormat;
-        if(!config.skipExistingVideos || !QFile::exists(videoDst)) {
-          if(QFile::exists(videoDst)) {
-            QFile::remove(videoDst);
-          }
-          if(config.symlink) {
-            // Try to remove existing video destination file before linking
-            if(!QFile::link(game.videoFile, videoDst)) {
-              game.videoFormat = "";
-            }
-          } else {
-            QFile videoFile(videoDst);
-            if(videoFile.open(QIODevice::WriteOnly)) {
-              videoFile.write(game.videoData);
-              videoFile.close();
-            } else {
-              game.videoFormat = "";
-            }
-          }
+    stages->add(STAGEFETCH, stageTimer.restart());
+
+    ScrapedEntry entry;
+    entry.info = info;
+    entry.game = game;
+    entry.cachedGame = cachedGame;
+    entry.output = output;
+    entry.debug = debug;
+    entry.lowMatch = lowMatch;
+    entry.compareTitle = compareTitle;
+    entry.fromCache = fromCache;
+    entry.potentialUpdates = potentialUpdates;
+    // The request counters belong to the scraper, so this check stays on this thread
+    if(!forceEnd) {
+      forceEnd = limitReached(entry.limitOutput);
+    }
+    if(config.pipelineThreads > 0) {
+      QElapsedTimer waitTimer;
+      waitTimer.start();
+      stages->commitSlots.acquire();
+      stages->waitMsecs += waitTimer.elapsed();
+      QMutableListIterator<QFuture<void> > it(commits);
+      while(it.hasNext()) {
+        if(it.next().isFinished()) {
+          it.remove();
         }
       }
-      // Copy or symlink manuals as requested
-      if(config.manuals &&
-         !game.manualFormat.isEmpty() &&
-         !game.manualFile.isEmpty() &&
-         QFile::exists(game.manualFile)) {
-        QString manualDst = config.manualsFolder + "/" + info.completeBaseName() +
-                            "." + game.manualFormat;
-        if(config.skipExistingManuals && QFile::exists(manualDst)) {
-        } else {
-          if(QFile::exists(manualDst)) {
-            QFile::remove(manualDst);
+      commits.append(QtConcurrent::run(&stages->commitPool, [this, entry]() mutable {
+        QElapsedTimer commitTimer;
+        commitTimer.start();
+        // saveAll() changes the layers of the compositor, so commits running at the same
+        // time each need their own. The artwork xml was already validated when the worker
+        // started
+        Compositor *commitCompositor = nullptr;
+        {
+          QMutexLocker locker(&compositorMutex);
+          if(!idleCompositors.isEmpty()) {
+            commitCompositor = idleCompositors.takeLast();
           }
-          if(config.symlink) {
-            // Try to remove existing manual destination file before linking
-            if(!QFile::link(game.manualFile, manualDst)) {
-              game.manualFormat = "";
-            }
-          } else {
-            QFile manualFile(manualDst);
-            if(manualFile.open(QIODevice::WriteOnly)) {
-              manualFile.write(game.manualData);
-              manualFile.close();
-            } else {
-              game.manualFormat = "";
-            }
+        }
+        if(commitCompositor == nullptr) {
+          commitCompositor = new Compositor(&config);
+          if(config.scraper == "cache") {
+            commitCompositor->processXml();
           }
         }
-      }
+        commitEntry(entry, *commitCompositor);
+        {
+          QMutexLocker locker(&compositorMutex);
+          idleCompositors.append(commitCompositor);
+        }
+        stages->add(STAGECOMMIT, commitTimer.elapsed());
+        stages->commitSlots.release();
+      }));
+    } else {
+      commitEntry(entry, compositor);
+      stages->add(STAGECOMMIT, stageTimer.restart());
     }
-
-    // Add all resources to the cache
-    QString cacheOutput = "";
-    if(config.scraper != "cache" && game.found && (!fromCache || potentialUpdates)) {
-     // Very ugly hack because it's actually more than one database (3/3):
-      if(config.scraper == "docsdb") {
-        game.source = Skyscraper::docType;
-      } else {
-        game.source = config.scraper;
-      }
-
-      cache->addResources(game, config, cacheOutput);
+    if(forceEnd) {
+      break;
     }
+  }
 
-    // We're done saving the raw data at this point, so feel free to manipulate
-    // game resources to better suit game list creation from here on out.
+  // Entries still in the commit stage must be emitted before the run is declared done
+  for(auto &commit: commits) {
+    commit.waitForFinished();
+  }
+  commits.clear();
+  qDeleteAll(idleCompositors);
+  idleCompositors.clear();
 
-    // Strip any brackets from the title as they will be read when assembling gamelist
-    game.title = StrTools::stripBrackets(game.title);
+  delete scraper;
+  emit allDone();
+}
 
-    // Move 'The' or ', The' depending on the config. This does not affect game list sorting.
-    // 'The ' is always removed before sorting.
-    game.title = NameTools::moveArticle(game.title, config.theInFront);
+void ScraperWorker::commitEntry(ScrapedEntry &entry, Compositor &compositor)
+{
+  const QFileInfo &info = entry.info;
+  GameEntry &game = entry.game;
+  QString &output = entry.output;
+  const QString &compareTitle = entry.compareTitle;
+  const bool fromCache = entry.fromCache;
+  const bool potentialUpdates = entry.potentialUpdates;
 
-    // Don't unescape title since we already did that in getBestEntry()
-    if(!game.videoFormat.isEmpty()) {
-      game.videoFile = StrTools::xmlUnescape(config.videosFolder + "/" +
-                       info.completeBaseName() + "." + game.videoFormat);
-    }
-    if(!game.manualFormat.isEmpty()) {
-      game.manualFile = StrTools::xmlUnescape(config.manualsFolder + "/" +
-                        info.completeBaseName() + "." + game.manualFormat);
-    }
-    game.chiptuneId = StrTools::xmlUnescape(game.chiptuneId);
-    game.chiptunePath = StrTools::xmlUnescape(game.chiptunePath);
-    game.guides = StrTools::xmlUnescape(game.guides);
-    game.cheats = StrTools::xmlUnescape(game.cheats);
-    game.reviews = StrTools::xmlUnescape(game.reviews);
-    game.artbooks = StrTools::xmlUnescape(game.artbooks);
-    game.vgmaps = StrTools::xmlUnescape(game.vgmaps);
-    game.sprites = StrTools::xmlUnescape(game.sprites);
-    game.description = StrTools::xmlUnescape(game.description);
-    game.trivia = StrTools::xmlUnescape(game.trivia);
-    game.releaseDate = StrTools::xmlUnescape(game.releaseDate);
-    // Make sure we have the correct 'yyyymmdd' format of 'releaseDate'
-    game.releaseDate = StrTools::conformReleaseDate(game.releaseDate);
-    game.developer = StrTools::xmlUnescape(game.developer);
-    game.publisher = StrTools::xmlUnescape(game.publisher);
-    game.tags = StrTools::xmlUnescape(game.tags);
-    game.tags = StrTools::conformTags(game.tags);
-    game.franchises = StrTools::xmlUnescape(game.franchises);
-    game.franchises = StrTools::conformTags(game.franchises);
-    game.rating = StrTools::xmlUnescape(game.rating);
-    game.players = StrTools::xmlUnescape(game.players);
-    // Make sure we have the correct single digit format of 'players'
-    game.players = StrTools::conformPlayers(game.players);
-    game.ages = StrTools::xmlUnescape(game.ages);
-    // Make sure we have the correct format of 'ages'
-    game.ages = StrTools::conformAges(game.ages);
-
-    output.append("Scraper:        " + config.scraper + "\n");
-    if(config.scraper != "cache" && config.scraper != "import") {
-      output.append("From cache:     " + QString((fromCache?"YES (refresh from source with '--cache refresh')":"NO")) + "\n");
-      output.append("Search match:   " + QString::number(game.searchMatch) + " %\n");
-      output.append("Compare title:  '\033[1;32m" + compareTitle + "\033[0m'\n");
-      output.append("Result title:   '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
-    } else {
-      output.append("Title:          '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
-    }
-    if(!config.nameTemplate.isEmpty()) {
-      game.title = StrTools::xmlUnescape(NameTools::getNameFromTemplate(game,
-                                                                        config.nameTemplate));
-    } else {
-      game.title = StrTools::xmlUnescape(game.title);
-      if(config.forceFilename) {
-        game.title = StrTools::xmlUnescape(StrTools::stripBrackets(info.completeBaseName()));
+  if(!config.pretend && config.scraper == "cache") {
+    // Process all artwork
+    compositor.saveAll(game, info.completeBaseName());
+    // Copy or symlink videos as requested
+    if(config.videos &&
+       !game.videoFormat.isEmpty() &&
+       !game.videoFile.isEmpty() &&
+       QFile::exists(game.videoFile)) {
+      QString videoDst = config.videosFolder + "/" + info.completeBaseName() +
+                         "." + game.videoFormat;
+      if(!config.skipExistingVideos || !QFile::exists(videoDst)) {
+        if(QFile::exists(videoDst)) {
+          QFile::remove(videoDst);
+        }
+        if(config.symlink) {
+          // Try to remove existing video destination file before linking
+          if(!QFile::link(game.videoFile, videoDst)) {
+            game.videoFormat = "";
+          }
+        } else {
+          if(!QFile::copy(game.videoFile, videoDst)) {
+            game.videoFormat = "";
+          }
+        }
       }
-      if(config.brackets) {
-        game.title.append(StrTools::xmlUnescape((game.parNotes != ""?" " + game.parNotes:QString("")) +
-                                                (game.sqrNotes != ""?" " + game.sqrNotes:QString(""))));
+    }
+    // Copy or symlink manuals as requested
+    if(config.manuals &&
+       !game.manualFormat.isEmpty() &&
+       !game.manualFile.isEmpty() &&
+       QFile::exists(game.manualFile)) {
+      QString manualDst = config.manualsFolder + "/" + info.completeBaseName() +
+                          "." + game.manualFormat;
+      if(config.skipExistingManuals && QFile::exists(manualDst)) {
+      } else {
+        if(QFile::exists(manualDst)) {
+          QFile::remove(manualDst);
+        }
+        if(config.symlink) {
+          // Try to remove existing manual destination file before linking
+          if(!QFile::link(game.manualFile, manualDst)) {
+            game.manualFormat = "";
+          }
+        } else {
+          if(!QFile::copy(game.manualFile, manualDst)) {
+            game.manualFormat = "";
+          }
+        }
       }
     }
-    output.append("Platform:       '\033[1;32m" + game.platform + "\033[0m' (" + game.platformSrc + ")\n");
-    output.append("Release Date:   '\033[1;32m");
-    if(game.releaseDate.isEmpty()) {
-      output.append("\033[0m' ()\n");
+  }
+
+  // Streamed videos and manuals have no data in memory, and addResources() moves their
+  // files into the cache, so their sizes are taken now for the size limit notice
+  const qint64 videoSize = (cache->isDownload(game.videoFile)?QFileInfo(game.videoFile).size():
+                            game.videoData.size());
+  const qint64 manualSize = (cache->isDownload(game.manualFile)?QFileInfo(game.manualFile).size():
+                             game.manualData.size());
+
+  // Add all resources to the cache
+  QString cacheOutput = "";
+  if(config.scraper != "cache" && game.found && (!fromCache || potentialUpdates)) {
+   // Very ugly hack because it's actually more than one database (3/3):
+    if(config.scraper == "docsdb") {
+      game.source = Skyscraper::docType;
     } else {
-      output.append(QDate::fromString(game.releaseDate, "yyyyMMdd").toString("yyyy-MM-dd") + "\033[0m' (" + game.releaseDateSrc + ")\n");
-    }
-    output.append("Id:             '\033[1;32m" + game.id + "\033[0m' (" + game.idSrc + ")\n");
-    output.append("Developer:      '\033[1;32m" + game.developer + "\033[0m' (" + game.developerSrc + ")\n");
-    output.append("Publisher:      '\033[1;32m" + game.publisher + "\033[0m' (" + game.publisherSrc + ")\n");
-    output.append("Players:        '\033[1;32m" + game.players + "\033[0m' (" + game.playersSrc + ")\n");
-    output.append("Ages:           '\033[1;32m" + game.ages + (game.ages.toInt() != 0?"+":"") + "\033[0m' (" + game.agesSrc + ")\n");
-    output.append("Tags:           '\033[1;32m" + game.tags + "\033[0m' (" + game.tagsSrc + ")\n");
-    output.append("Franchises:     '\033[1;32m" + game.franchises + "\033[0m' (" + game.franchisesSrc + ")\n");
-    output.append("Rating (0-1):   '\033[1;32m" + game.rating + "\033[0m' (" + game.ratingSrc + ")\n");
-    output.append("Guides:         '\033[1;32m" + game.guides + "\033[0m' (" + game.guidesSrc + ")\n");
-    output.append("Cheats:         '\033[1;32m" + game.cheats + "\033[0m' (" + game.cheatsSrc + ")\n");
-    output.append("Reviews:        '\033[1;32m" + game.reviews + "\033[0m' (" + game.reviewsSrc + ")\n");
-    output.append("Artbooks:       '\033[1;32m" + game.artbooks + "\033[0m' (" + game.artbooksSrc + ")\n");
-    output.append("Maps:           '\033[1;32m" + game.vgmaps + "\033[0m' (" + game.vgmapsSrc + ")\n");
-    output.append("Sprites:        '\033[1;32m" + game.sprites + "\033[0m' (" + game.spritesSrc + ")\n");
-    output.append("Cover:          " + QString(((game.coverData.isNull() && game.coverFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheCovers || config.scraper == "cache"?"":" (uncached)")) + " (" + game.coverSrc + ")\n");
-    output.append("Screenshot:     " + QString(((game.screenshotData.isNull() && game.coverFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheScreenshots || config.scraper == "cache"?"":" (uncached)")) + " (" + game.screenshotSrc + ")\n");
-    output.append("Wheel:          " + QString(((game.wheelData.isNull() && game.wheelFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheWheels || config.scraper == "cache"?"":" (uncached)")) + " (" + game.wheelSrc + ")\n");
-    output.append("Marquee:        " + QString(((game.marqueeData.isNull() && game.marqueeFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheMarquees || config.scraper == "cache"?"":" (uncached)")) + " (" + game.marqueeSrc + ")\n");
-    output.append("Texture:        " + QString(((game.textureData.isNull() && game.textureFile.isEmpty())? "\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheTextures || config.scraper == "cache"?"":" (uncached)")) + " (" + game.textureSrc + ")\n");
-    if(config.videos) {
-      output.append("Video:          " + QString((game.videoFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((game.videoData.size() <= config.videoSizeLimit?"":" (size exceeded, uncached)")) + " (" + game.videoSrc + ")\n");
+      game.source = config.scraper;
     }
-    if(config.manuals) {
-      output.append("Manual:         " + QString((game.manualFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((game.manualData.size() <= config.manualSizeLimit?"":" (size exceeded, uncached)")) + " (" + game.manualSrc + ")\n");
-    }
-    if(config.chiptunes) {
-      output.append("Chiptunes:      " + QString((game.chiptuneId.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + " (" + game.chiptuneIdSrc + ")\n");
-    }
-    output.append("\nDescription: (" + game.descriptionSrc + ")\n'\033[1;32m" + game.description.left(config.maxLength) + "\033[0m'\n");
-    output.append("\nTrivia: (" + game.triviaSrc + ")\n'\033[1;32m" + game.trivia.left(config.maxLength) + "\033[0m'\n");
-    if(!cacheOutput.isEmpty()) {
-      output.append("\n\033[1;33mCache output:\033[0m\n" + cacheOutput + "\n");
-    }
-    if(!forceEnd) {
-      forceEnd = limitReached(output);
+
+    cache->addResources(game, config, cacheOutput);
+  }
+  // The game is stored, so its changes can be saved without holding up the other threads
+  cache->flushJournal();
+  // Streamed videos and manuals the cache didn't take, like the ones over the size limit
+  if(cache->isDownload(game.videoFile)) {
+    QFile::remove(game.videoFile);
+  }
+  if(cache->isDownload(game.manualFile)) {
+    QFile::remove(game.manualFile);
+  }
+
+  // We're done saving the raw data at this point, so feel free to manipulate
+  // game resources to better suit game list creation from here on out.
+
+  // Strip any brackets from the title as they will be read when assembling gamelist
+  game.title = StrTools::stripBrackets(game.title);
+
+  // Move 'The' or ', The' depending on the config. This does not affect game list sorting.
+  // 'The ' is always removed before sorting.
+  game.title = NameTools::moveArticle(game.title, config.theInFront);
+
+  // Don't unescape title since we already did that in getBestEntry()
+  if(!game.videoFormat.isEmpty()) {
+    game.videoFile = StrTools::xmlUnescape(config.videosFolder + "/" +
+                     info.completeBaseName() + "." + game.videoFormat);
+  }
+  if(!game.manualFormat.isEmpty()) {
+    game.manualFile = StrTools::xmlUnescape(config.manualsFolder + "/" +
+                      info.completeBaseName() + "." + game.manualFormat);
+  }
+  game.chiptuneId = StrTools::xmlUnescape(game.chiptuneId);
+  game.chiptunePath = StrTools::xmlUnescape(game.chiptunePath);
+  game.guides = StrTools::xmlUnescape(game.guides);
+  game.cheats = StrTools::xmlUnescape(game.cheats);
+  game.reviews = StrTools::xmlUnescape(game.reviews);
+  game.artbooks = StrTools::xmlUnescape(game.artbooks);
+  game.vgmaps = StrTools::xmlUnescape(game.vgmaps);
+  game.sprites = StrTools::xmlUnescape(game.sprites);
+  game.description = StrTools::xmlUnescape(game.description);
+  game.trivia = StrTools::xmlUnescape(game.trivia);
+  game.releaseDate = StrTools::xmlUnescape(game.releaseDate);
+  // Make sure we have the correct 'yyyymmdd' format of 'releaseDate'
+  game.releaseDate = StrTools::conformReleaseDate(game.releaseDate);
+  game.developer = StrTools::xmlUnescape(game.developer);
+  game.publisher = StrTools::xmlUnescape(game.publisher);
+  game.tags = StrTools::xmlUnescape(game.tags);
+  game.tags = StrTools::conformTags(game.tags);
+  game.franchises = StrTools::xmlUnescape(game.franchises);
+  game.franchises = StrTools::conformTags(game.franchises);
+  game.rating = StrTools::xmlUnescape(game.rating);
+  game.players = StrTools::xmlUnescape(game.players);
+  // Make sure we have the correct single digit format of 'players'
+  game.players = StrTools::conformPlayers(game.players);
+  game.ages = StrTools::xmlUnescape(game.ages);
+  // Make sure we have the correct format of 'ages'
+  game.ages = StrTools::conformAges(game.ages);
+
+  output.append("Scraper:        " + config.scraper + "\n");
+  if(config.scraper != "cache" && config.scraper != "import") {
+    output.append("From cache:     " + QString((fromCache?"YES (refresh from source with '--cache refresh')":"NO")) + "\n");
+    output.append("Search match:   " + QString::number(game.searchMatch) + " %\n");
+    output.append("Compare title:  '\033[1;32m" + compareTitle + "\033[0m'\n");
+    output.append("Result title:   '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
+  } else {
+    output.append("Title:          '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
+  }
+  if(!config.nameTemplate.isEmpty()) {
+    game.title = StrTools::xmlUnescape(NameTools::getNameFromTemplate(game,
+                                                                      config.nameTemplate));
+  } else {
+    game.title = StrTools::xmlUnescape(game.title);
+    if(config.forceFilename) {
+      game.title = StrTools::xmlUnescape(StrTools::stripBrackets(info.completeBaseName()));
     }
-    game.resetMedia();
-    cachedGame.resetMedia();
-    emit entryReady(game, output, debug, lowMatch);
-    if(forceEnd) {
-      break;
+    if(config.brackets) {
+      game.title.append(StrTools::xmlUnescape((game.parNotes != ""?" " + game.parNotes:QString("")) +
+                                              (game.sqrNotes != ""?" " + game.sqrNotes:QString(""))));
     }
   }
-
-  delete scraper;
-  emit allDone();
+  output.append("Platform:       '\033[1;32m" + game.platform + "\033[0m' (" + game.platformSrc + ")\n");
+  output.append("Release Date:   '\033[1;32m");
+  if(game.releaseDate.isEmpty()) {
+    output.append("\033[0m' ()\n");
+  } else {
+    output.append(QDate::fromString(game.releaseDate, "yyyyMMdd").toString("yyyy-MM-dd") + "\033[0m' (" + game.releaseDateSrc + ")\n");
+  }
+  output.append("Id:             '\033[1;32m" + game.id + "\033[0m' (" + game.idSrc + ")\n");
+  output.append("Developer:      '\033[1;32m" + game.developer + "\033[0m' (" + game.developerSrc + ")\n");
+  output.append("Publisher:      '\033[1;32m" + game.publisher + "\033[0m' (" + game.publisherSrc + ")\n");
+  output.append("Players:        '\033[1;32m" + game.players + "\033[0m' (" + game.playersSrc + ")\n");
+  output.append("Ages:           '\033[1;32m" + game.ages + (game.ages.toInt() != 0?"+":"") + "\033[0m' (" + game.agesSrc + ")\n");
+  output.append("Tags:           '\033[1;32m" + game.tags + "\033[0m' (" + game.tagsSrc + ")\n");
+  output.append("Franchises:     '\033[1;32m" + game.franchises + "\033[0m' (" + game.franchisesSrc + ")\n");
+  output.append("Rating (0-1):   '\033[1;32m" + game.rating + "\033[0m' (" + game.ratingSrc + ")\n");
+  output.append("Guides:         '\033[1;32m" + game.guides + "\033[0m' (" + game.guidesSrc + ")\n");
+  output.append("Cheats:         '\033[1;32m" + game.cheats + "\033[0m' (" + game.cheatsSrc + ")\n");
+  output.append("Reviews:        '\033[1;32m" + game.reviews + "\033[0m' (" + game.reviewsSrc + ")\n");
+  output.append("Artbooks:       '\033[1;32m" + game.artbooks + "\033[0m' (" + game.artbooksSrc + ")\n");
+  output.append("Maps:           '\033[1;32m" + game.vgmaps + "\033[0m' (" + game.vgmapsSrc + ")\n");
+  output.append("Sprites:        '\033[1;32m" + game.sprites + "\033[0m' (" + game.spritesSrc + ")\n");
+  output.append("Cover:          " + QString(((game.coverData.isNull() && game.coverFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheCovers || config.scraper == "cache"?"":" (uncached)")) + " (" + game.coverSrc + ")\n");
+  output.append("Screenshot:     " + QString(((game.screenshotData.isNull() && game.coverFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheScreenshots || config.scraper == "cache"?"":" (uncached)")) + " (" + game.screenshotSrc + ")\n");
+  output.append("Wheel:          " + QString(((game.wheelData.isNull() && game.wheelFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheWheels || config.scraper == "cache"?"":" (uncached)")) + " (" + game.wheelSrc + ")\n");
+  output.append("Marquee:        " + QString(((game.marqueeData.isNull() && game.marqueeFile.isEmpty())?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheMarquees || config.scraper == "cache"?"":" (uncached)")) + " (" + game.marqueeSrc + ")\n");
+  output.append("Texture:        " + QString(((game.textureData.isNull() && game.textureFile.isEmpty())? "\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheTextures || config.scraper == "cache"?"":" (uncached)")) + " (" + game.textureSrc + ")\n");
+  if(config.videos) {
+    output.append("Video:          " + QString((game.videoFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((videoSize <= config.videoSizeLimit?"":" (size exceeded, uncached)")) + " (" + game.videoSrc + ")\n");
+  }
+  if(config.manuals) {
+    output.append("Manual:         " + QString((game.manualFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((manualSize <= config.manualSizeLimit?"":" (size exceeded, uncached)")) + " (" + game.manualSrc + ")\n");
+  }
+  if(config.chiptunes) {
+    output.append("Chiptunes:      " + QString((game.chiptuneId.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + " (" + game.chiptuneIdSrc + ")\n");
+  }
+  output.append("\nDescription: (" + game.descriptionSrc + ")\n'\033[1;32m" + game.description.left(config.maxLength) + "\033[0m'\n");
+  output.append("\nTrivia: (" + game.triviaSrc + ")\n'\033[1;32m" + game.trivia.left(config.maxLength) + "\033[0m'\n");
+  if(!cacheOutput.isEmpty()) {
+    output.append("\n\033[1;33mCache output:\033[0m\n" + cacheOutput + "\n");
+  }
+  output.append(entry.limitOutput);
+  game.resetMedia();
+  entry.cachedGame.resetMedia();
+  emit entryReady(game, output, entry.debug, entry.lowMatch);
 }
 
 bool ScraperWorker::limitReached(QString &output)
@@ -26,6 +26,12 @@
 #ifndef SCRAPERWORKER_H
 #define SCRAPERWORKER_H
 
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QFuture>
+#include <QMutex>
+#include <QElapsedTimer>
+
 #include "abstractscraper.h"
 #include "settings.h"
 #include "cache.h"
@@ -33,6 +39,43 @@
 #include "nametools.h"
 #include "netmanager.h"
 
+class Compositor;
+
+constexpr int STAGEHASH = 0;
+constexpr int STAGESEARCH = 1;
+constexpr int STAGEFETCH = 2;
+constexpr int STAGECOMMIT = 3;
+constexpr int STAGECOUNT = 4;
+
+// Shared by all the workers of a run. The time spent per stage shows which stage holds
+// the run back. With 'pipelineThreads' set the commit stage runs on 'commitPool'
+struct ScraperStages {
+  void add(const int stage, const qint64 elapsed);
+  void print(const bool pipelined);
+
+  QThreadPool commitPool;
+  // One slot per rom waiting for or in the commit stage, so a slow disk throttles the
+  // scraping threads instead of piling up fetched media in memory
+  QSemaphore commitSlots;
+  QAtomicInteger<qint64> msecs[STAGECOUNT];
+  QAtomicInt roms[STAGECOUNT];
+  QAtomicInteger<qint64> waitMsecs = 0;
+};
+
+// A rom that has been searched and fetched, with everything the commit stage needs
+struct ScrapedEntry {
+  QFileInfo info;
+  GameEntry game;
+  GameEntry cachedGame;
+  QString output;
+  QString debug;
+  QString lowMatch;
+  QString compareTitle;
+  QString limitOutput;
+  bool fromCache = false;
+  bool potentialUpdates = false;
+};
+
 class ScraperWorker : public QObject
 {
   Q_OBJECT
@@ -42,7 +85,8 @@ public:
                 QSharedPointer<Cache> cache,
                 QSharedPointer<NetManager> manager,
                 Settings config,
-                QString threadId);
+                QString threadId,
+                QSharedPointer<ScraperStages> stages);
   ~ScraperWorker();
 
   // Instantiates the actual scraper and processes files from the list of files.
@@ -75,9 +119,20 @@ private:
   QSharedPointer<Cache> cache;
   QSharedPointer<NetManager> manager;
   QSharedPointer<Queue> queue;
+  QSharedPointer<ScraperStages> stages;
+  // Commits still in flight, finished ones are dropped as new ones are started
+  QList<QFuture<void> > commits;
+  // Compositors of the commits of this worker that are not in use. processXml() is costly,
+  // so they are reused rather than built for every rom
+  QList<Compositor *> idleCompositors;
+  QMutex compositorMutex;
 
   QString threadId;
 
+  // Composites the artwork, adds the resources to the cache and builds the output of an
+  // entry. Runs on the scraping thread, or on the commit pool with 'pipelineThreads' set
+  void commitEntry(ScrapedEntry &entry, Compositor &compositor);
+
   GameEntry getEntryFromUser(const QList<GameEntry> &gameEntries, const GameEntry &suggestedGame,
                              const QString &compareTitle, int &lowestDistance);
 
@@ -58,12 +58,6 @@ ScreenScraper::ScreenScraper(Settings *config,
     return;
   }
 
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  // 1.2 second request limit set a bit above 1.0 as requested by the folks at ScreenScraper. Don't change!
-  limitTimer.setInterval(1200);
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
-
   baseUrl = "http://www.screenscraper.fr";
 
   fetchOrder.append(ID);
@@ -99,9 +93,9 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
 
   searchError = false;
   for(int retries = 0; retries < RETRIESMAX; ++retries) {
-    limiter.exec();
     printf("1"); fflush(stdout);
-    netComm->request(gameUrl);
+    // The reply also reports the requests left today, so it must always be fresh
+    netComm->requestUncached(gameUrl);
     q.exec();
     data = netComm->getData();
 
@@ -410,19 +404,10 @@ void ScreenScraper::getFranchises(GameEntry &game)
 
 void ScreenScraper::getCover(GameEntry &game)
 {
-  QString url = "";
-  if(Platform::get().getFamily(config->platform) == "arcade" &&
-     config->platform != "gameandwatch") {
-    url = getJsonText(jsonObj["medias"].toArray(), REGION,
-                      QStringList({"flyer"}));
-  } else {
-    url = getJsonText(jsonObj["medias"].toArray(), REGION,
-                      QStringList({"box-2D", "box-2d", "flyer", "box-texture"}));
-  }
+  QString url = getMediaUrl(COVER);
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("2"); fflush(stdout);
       netComm->request(url);
       q.exec();
@@ -442,12 +427,10 @@ void ScreenScraper::getCover(GameEntry &game)
 
 void ScreenScraper::getScreenshot(GameEntry &game)
 {
-  QString url = getJsonText(jsonObj["medias"].toArray(), REGION,
-                            QStringList({"ss"}));
+  QString url = getMediaUrl(SCREENSHOT);
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("3"); fflush(stdout);
       netComm->request(url);
       q.exec();
@@ -467,12 +450,10 @@ void ScreenScraper::getScreenshot(GameEntry &game)
 
 void ScreenScraper::getWheel(GameEntry &game)
 {
-  QString url = getJsonText(jsonObj["medias"].toArray(), REGION,
-                            QStringList({"sstitle"/*, "wheel", "wheel-hd"*/}));
+  QString url = getMediaUrl(WHEEL);
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("4"); fflush(stdout);
       netComm->request(url);
       q.exec();
@@ -492,13 +473,10 @@ void ScreenScraper::getWheel(GameEntry &game)
 
 void ScreenScraper::getMarquee(GameEntry &game)
 {
-  QString url = getJsonText(jsonObj["medias"].toArray(), REGION,
-                            QStringList({"fanart-hd", "fanart", "support-2D", "support-2d",
-                                         "support-texture"/*, "marquee", "screenmarquee"*/}));
+  QString url = getMediaUrl(MARQUEE);
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("5"); fflush(stdout);
       netComm->request(url);
       q.exec();
@@ -517,12 +495,10 @@ void ScreenScraper::getMarquee(GameEntry &game)
 }
 
 void ScreenScraper::getTexture(GameEntry &game) {
-  QString url = getJsonText(jsonObj["medias"].toArray(), REGION,
-                            QStringList({"box-2D-back", "box-2d-back"}));
+  QString url = getMediaUrl(TEXTURE);
   if(!url.isEmpty()) {
     bool moveOn = false;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("6"); fflush(stdout);
       netComm->request(url);
       q.exec();
@@ -543,28 +519,20 @@ void ScreenScraper::getTexture(GameEntry &game) {
 
 void ScreenScraper::getVideo(GameEntry &game)
 {
-  QStringList types;
-  if(config->videoPreferNormalized) {
-    types.append("video-normalized");
-  }
-  types.append("video");
-  QString url = getJsonText(jsonObj["medias"].toArray(), NONE, types);
+  QString url = getMediaUrl(VIDEO);
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("7"); fflush(stdout);
-      netComm->request(url);
-      q.exec();
-      game.videoData = netComm->getData();
+      const qint64 videoSize = getMediaData(url, game.videoData, game.videoFile);
       // Make sure received data is actually a video file
       QByteArray contentType = netComm->getContentType();
       if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-         contentType.contains("video/") && game.videoData.size() > 4096) {
+         contentType.contains("video/") && videoSize > 4096) {
         game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
                                            contentType.length() - contentType.indexOf("/") + 1);
       } else {
-        game.videoData = "";
+        discardMediaData(game.videoData, game.videoFile);
         moveOn = false;
       }
       if(moveOn)
@@ -575,28 +543,23 @@ void ScreenScraper::getVideo(GameEntry &game)
 
 void ScreenScraper::getManual(GameEntry &game)
 {
-  QStringList types;
-  types.append("manuel");
-  QString url = getJsonText(jsonObj["medias"].toArray(), REGION, types);
+  QString url = getMediaUrl(MANUAL);
   if(!url.isEmpty()) {
     bool moveOn = true;
     for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
       printf("8"); fflush(stdout);
-      netComm->request(url);
-      q.exec();
-      game.manualData = netComm->getData();
+      const qint64 manualSize = getMediaData(url, game.manualData, game.manualFile);
       // Make sure received the data is not empty and has a type
       QByteArray contentType = netComm->getContentType();
       if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-         !contentType.isEmpty() && game.manualData.size() > 4096) {
+         !contentType.isEmpty() && manualSize > 4096) {
         game.manualFormat = contentType.mid(contentType.indexOf("/") + 1,
                                             contentType.length() - contentType.indexOf("/") + 1);
         if(game.manualFormat.length()>4) {
           game.manualFormat = "pdf";
         }
       } else {
-        game.manualData = "";
+        discardMediaData(game.manualData, game.manualFile);
         moveOn = false;
       }
       if(moveOn)
@@ -605,6 +568,52 @@ void ScreenScraper::getManual(GameEntry &game)
   }
 }
 
+// The url the media getters above request first for 'type'.
+QString ScreenScraper::getMediaUrl(const int type)
+{
+  const QJsonArray medias = jsonObj["medias"].toArray();
+  switch(type) {
+  case COVER:
+    if(Platform::get().getFamily(config->platform) == "arcade" &&
+       config->platform != "gameandwatch") {
+      return getJsonText(medias, REGION, QStringList({"flyer"}));
+    }
+    return getJsonText(medias, REGION,
+                       QStringList({"box-2D", "box-2d", "flyer", "box-texture"}));
+  case SCREENSHOT:
+    return getJsonText(medias, REGION, QStringList({"ss"}));
+  case WHEEL:
+    return getJsonText(medias, REGION, QStringList({"sstitle"/*, "wheel", "wheel-hd"*/}));
+  case MARQUEE:
+    return getJsonText(medias, REGION,
+                       QStringList({"fanart-hd", "fanart", "support-2D", "support-2d",
+                                    "support-texture"/*, "marquee", "screenmarquee"*/}));
+  case TEXTURE:
+    return getJsonText(medias, REGION, QStringList({"box-2D-back", "box-2d-back"}));
+  case VIDEO: {
+    QStringList types;
+    if(config->videoPreferNormalized) {
+      types.append("video-normalized");
+    }
+    types.append("video");
+    return getJsonText(medias, NONE, types);
+  }
+  case MANUAL:
+    return getJsonText(medias, REGION, QStringList({"manuel"}));
+  default:
+    return QString();
+  }
+}
+
+QStringList ScreenScraper::getMediaUrls(GameEntry &, const QList<int> &types)
+{
+  QStringList urls;
+  for(const auto type: std::as_const(types)) {
+    urls.append(getMediaUrl(type));
+  }
+  return urls;
+}
+
 QStringList ScreenScraper::getSearchNames(const QFileInfo &info)
 {
   QStringList searchNames;
@@ -27,8 +27,6 @@
 #define SCREENSCRAPER_H
 
 #include <QJsonObject>
-#include <QTimer>
-#include <QEventLoop>
 
 #include "abstractscraper.h"
 
@@ -67,12 +65,12 @@ protected:
   void getTexture(GameEntry &game) override;
   void getVideo(GameEntry &game) override;
   void getManual(GameEntry &game) override;
+  QStringList getMediaUrls(GameEntry &game, const QList<int> &types) override;
 
 private:
   QString getJsonText(QJsonArray array, int attr, QStringList types = QStringList());
+  QString getMediaUrl(const int type);
 
-  QTimer limitTimer;
-  QEventLoop limiter;
 
   QString region;
   QString lang;
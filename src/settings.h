@@ -38,6 +38,9 @@ struct Settings {
   bool waitIfConcurrent = false;
   bool useChecksum = false;
   QString cacheFolder = "";
+  QString cacheFormat = "xml";
+  bool cacheDedup = false;
+  bool cacheShards = false;
   QString gameListFileString = "";
   QString skippedFileString = "";
   QString configFile = "";
@@ -77,6 +80,15 @@ struct Settings {
   int doneThreads = 0;
   int threads = 4;
   bool threadsSet = false;
+  int pipelineThreads = 0;
+  double requestRate = 0.0;
+  int requestBurst = 1;
+  int requestsInFlight = 0;
+  bool concurrentMedia = false;
+  bool streamMedia = true;
+  QString httpCacheFolder = "cache/http";
+  int httpCacheSize = 500; // MB, 0 disables the HTTP cache
+  int httpCacheTtl = 168; // Hours
   int minMatch = 65;
   int minMatchDetection = 80;
   bool minMatchSet = false;
@@ -149,32 +149,57 @@ void Skyscraper::run()
     showHint();
   }
 
+  if(config.cacheOptions == "http:purge") {
+    HttpCache httpCache(config.httpCacheFolder, 0, 0);
+    printf("Removed \033[1;33m%.1f\033[0m MB from the HTTP cache in '%s'.\n",
+           (double)httpCache.purge() / 1024.0 / 1024.0,
+           config.httpCacheFolder.toStdString().c_str());
+    removeLockAndExit(0);
+  }
+
   doPrescrapeJobs();
 
+  // Set after doPrescrapeJobs(), so the account and quota checks always reach the service
+  if(config.httpCacheSize > 0 && !config.scraper.isEmpty() && config.scraper != "cache") {
+    manager->setHttpCache(QSharedPointer<HttpCache>(
+                            new HttpCache(config.httpCacheFolder,
+                                          (qint64)config.httpCacheSize * 1024 * 1024,
+                                          (qint64)config.httpCacheTtl * 3600)));
+  }
+
   doneThreads = 0;
   notFound = 0;
   found = 0;
   avgCompleteness = 0;
   avgSearchMatch = 0;
 
+  auto noResources = [this]() {
+    printf("No resources for this platform found in the resource cache. Please "
+           "specify a scraping module with '-s' to gather some resources before "
+           "trying to generate a game list. Check all available modules with "
+           "'--help'. You can also run Skyscraper in simple mode by typing "
+           "'Skyscraper' and follow the instructions on screen.\n\n");
+    removeLockAndExit(1);
+  };
+  // Runs on a few given roms only need their resources, so those load the cache once
+  // the queue is known
+  const bool targeted = (!cliFiles.isEmpty() || !config.searchName.isEmpty() ||
+                         !config.startAt.isEmpty() || !config.endAt.isEmpty()) &&
+                        (config.cacheOptions.isEmpty() || config.cacheOptions == "refresh" ||
+                         config.cacheOptions == "rescan" || config.cacheOptions == "ignorenegativecache");
   if(!config.cacheFolder.isEmpty()) {
     cache = QSharedPointer<Cache>(new Cache(config.cacheFolder, config.scraper));
     NameTools::cache = cache;
     if(cache->createFolders()) {
-      if(!cache->read() && config.scraper == "cache") {
-        printf("No resources for this platform found in the resource cache. Please "
-               "specify a scraping module with '-s' to gather some resources before "
-               "trying to generate a game list. Check all available modules with "
-               "'--help'. You can also run Skyscraper in simple mode by typing "
-               "'Skyscraper' and follow the instructions on screen.\n\n");
-        removeLockAndExit(1);
+      if(!targeted && !cache->read() && config.scraper == "cache") {
+        noResources();
       }
     } else {
       printf("Couldn't create cache folders, please check folder permissions and try again...\n");
       removeLockAndExit(1);
     }
   }
-  if(config.verbosity || config.cacheOptions == "show") {
+  if((config.verbosity && !targeted) || config.cacheOptions == "show") {
     cache->showStats(config.cacheOptions == "show"?2:config.verbosity);
     if(config.cacheOptions == "show")
       removeLockAndExit(0);
@@ -216,15 +241,26 @@ void Skyscraper::run()
     state = 0;
     removeLockAndExit(0);
   }
+  if(config.cacheOptions.startsWith("convert:")) {
+    state = 1; // Ignore ctrl+c
+    cache->write(false, config.cacheOptions.mid(QString("convert:").length()));
+    state = 0;
+    removeLockAndExit(0);
+  }
+  if(config.cacheOptions == "compact") {
+    // read() has already replayed the journal, so writing folds it into db.xml
+    state = 1; // Ignore ctrl+c
+    cache->write();
+    state = 0;
+    removeLockAndExit(0);
+  }
   if(config.cacheOptions == "ignorenegativecache") {
     config.ignoreNegCache = true;
   }
   if(config.cacheOptions.contains("merge:")) {
     QFileInfo mergeCacheInfo(config.cacheOptions.replace("merge:", ""));
     if(mergeCacheInfo.exists()) {
-      Cache mergeCache(mergeCacheInfo.absoluteFilePath(), config.scraper);
-      mergeCache.read();
-      cache->merge(mergeCache, config.refresh, mergeCacheInfo.absoluteFilePath());
+      cache->merge(mergeCacheInfo.absoluteFilePath(), config.refresh);
       state = 1; // Ignore ctrl+c
       cache->write();
       state = 0;
@@ -378,6 +414,16 @@ void Skyscraper::run()
     }
   }
 
+  if(targeted) {
+    if(!cache->readSubset(*queue) && config.scraper == "cache") {
+      noResources();
+    }
+    if(config.verbosity) {
+      cache->showStats(config.verbosity);
+    }
+  }
+  cache->hashMissingQuickIds(*queue);
+
   state = 2; // Clear queue on ctrl+c
   if(config.cacheOptions.left(4) == "edit") {
     QString editCommand = "";
@@ -398,6 +444,11 @@ void Skyscraper::run()
   }
   state = 0;
 
+  if(config.scraper != "cache") {
+    // Persist new resources as they are scraped so an interrupted run doesn't lose them
+    cache->startJournal();
+  }
+
   if(!config.pretend && config.scraper == "cache" && config.gameListBackup) {
     QString gameListBackup = gameListFile.fileName() + "-" +
       QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
@@ -488,10 +539,16 @@ void Skyscraper::run()
   if(config.scraper == "docsdb" && !docTypeCurrent) {
     docType = config.docTypes.at(docTypeCurrent);
   }
+  stages = QSharedPointer<ScraperStages>(new ScraperStages());
+  if(config.pipelineThreads > 0) {
+    stages->commitPool.setMaxThreadCount(config.pipelineThreads);
+    stages->commitSlots.release(config.pipelineThreads * 2);
+  }
   QList<QThread*> threadList;
   for(int curThread = 1; curThread <= config.threads; ++curThread) {
     QThread *thread = new QThread;
-    ScraperWorker *worker = new ScraperWorker(queue, cache, manager, config, QString::number(curThread));
+    ScraperWorker *worker = new ScraperWorker(queue, cache, manager, config,
+                                              QString::number(curThread), stages);
     worker->moveToThread(thread);
     connect(thread, &QThread::started, worker, &ScraperWorker::run);
     connect(worker, &ScraperWorker::entryReady, this, &Skyscraper::entryReady);
@@ -723,6 +780,15 @@ void Skyscraper::checkThreads(const bool &stopNow)
     printf("\033[1;32mSuccessfully processed games: %d\033[0m\n", found);
     printf("\033[1;33mSkipped games: %d\033[0m (Filenames saved to '\033[1;33m%s/%s\033[0m')\n\n",
            notFound, QDir::currentPath().toStdString().c_str(), skippedFileString.toStdString().c_str());
+    if(config.verbosity >= 1 && config.threads > 1 && !config.cacheFolder.isEmpty()) {
+      cache->printLockStats();
+    }
+    if(config.verbosity >= 1 || config.pipelineThreads > 0) {
+      stages->print(config.pipelineThreads > 0);
+    }
+    if(config.verbosity >= 1 && !manager->getHttpCache().isNull()) {
+      manager->getHttpCache()->printStats();
+    }
   }
   // Very ugly hack because it's actually more than one database (2/3):
   if(config.scraper == "docsdb") {
@@ -882,6 +948,24 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     config.threads = settings.value("threads").toInt();
     config.threadsSet = true;
   }
+  if(settings.contains("pipelineThreads")) {
+    config.pipelineThreads = settings.value("pipelineThreads").toInt();
+  }
+  if(settings.contains("concurrentMedia")) {
+    config.concurrentMedia = settings.value("concurrentMedia").toBool();
+  }
+  if(settings.contains("streamMedia")) {
+    config.streamMedia = settings.value("streamMedia").toBool();
+  }
+  if(settings.contains("httpCacheFolder")) {
+    config.httpCacheFolder = settings.value("httpCacheFolder").toString();
+  }
+  if(settings.contains("httpCacheSize")) {
+    config.httpCacheSize = settings.value("httpCacheSize").toInt();
+  }
+  if(settings.contains("httpCacheTtl")) {
+    config.httpCacheTtl = settings.value("httpCacheTtl").toInt();
+  }
   if(settings.contains("emulator")) {
     config.frontendExtra = settings.value("emulator").toString();
   }
@@ -1110,6 +1194,21 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(settings.contains("spaceCheck")) {
     config.spaceCheck = settings.value("spaceCheck").toBool();
   }
+  if(settings.contains("cacheFormat")) {
+    QString cacheFormat = settings.value("cacheFormat").toString();
+    if(cacheFormat == "xml" || cacheFormat == "binary" || cacheFormat == "sqlite") {
+      config.cacheFormat = cacheFormat;
+    } else {
+      printf("\033[1;33mUnknown 'cacheFormat' value '%s', using 'xml'...\033[0m\n",
+             cacheFormat.toStdString().c_str());
+    }
+  }
+  if(settings.contains("cacheDedup")) {
+    config.cacheDedup = settings.value("cacheDedup").toBool();
+  }
+  if(settings.contains("cacheShards")) {
+    config.cacheShards = settings.value("cacheShards").toBool();
+  }
   if(settings.contains("fuzzySearch")) {
     config.fuzzySearch = settings.value("fuzzySearch").toInt();
   }
@@ -1229,6 +1328,9 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     config.threads = settings.value("threads").toInt();
     config.threadsSet = true;
   }
+  if(settings.contains("pipelineThreads")) {
+    config.pipelineThreads = settings.value("pipelineThreads").toInt();
+  }
   if(settings.contains("videos")) {
     config.videos = settings.value("videos").toBool();
   }
@@ -1576,6 +1678,24 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
     config.threads = settings.value("threads").toInt();
     config.threadsSet = true;
   }
+  if(settings.contains("requestRate")) {
+    config.requestRate = settings.value("requestRate").toDouble();
+  }
+  if(settings.contains("requestBurst")) {
+    config.requestBurst = settings.value("requestBurst").toInt();
+  }
+  if(settings.contains("requestsInFlight")) {
+    config.requestsInFlight = settings.value("requestsInFlight").toInt();
+  }
+  if(settings.contains("concurrentMedia")) {
+    config.concurrentMedia = settings.value("concurrentMedia").toBool();
+  }
+  if(settings.contains("streamMedia")) {
+    config.streamMedia = settings.value("streamMedia").toBool();
+  }
+  if(settings.contains("httpCacheTtl")) {
+    config.httpCacheTtl = settings.value("httpCacheTtl").toInt();
+  }
   if(settings.contains("minMatch")) {
     config.minMatch = settings.value("minMatch").toInt();
     config.minMatchSet = true;
@@ -1974,8 +2094,11 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
       config.refresh = false;
     } else if(config.cacheOptions == "help") {
       printf("Showing '\033[1;33m--cache\033[0m' help\n");
+      printf("  \033[1;33m--cache compact\033[0m: Folds the changes recorded in the cache journal ('db.journal') into 'db.xml'. Only needed after a scraping run that didn't finish normally.\n");
+      printf("  \033[1;33m--cache convert:<FORMAT>\033[0m: Rewrites the resource cache of the selected platform in the given format, either 'xml' ('db.xml'), 'binary' ('db.bin') or 'sqlite' ('db.sqlite'). Use it to import or export a cache to / from XML. Set 'cacheFormat' in config.ini to keep using that format afterwards.\n");
       printf("  \033[1;33m--cache edit\033[0m: Let's you edit resources for the selected platform for all files or a range of files. Add a filename on command line to edit cached resources for just that one file, use '--includefrom' to edit files created with the '--cache report' option or use '--startat' and '--endat' to edit a range of roms.\n");
       printf("  \033[1;33m--cache edit:new=<TYPE>\033[0m: Let's you batch add resources of <TYPE> to the selected platform for all files or a range of files. Add a filename on command line to edit cached resources for just that one file, use '--includefrom' to edit files created with the '--cache report' option or use '--startat' and '--endat' to edit a range of roms.\n");
+      printf("  \033[1;33m--cache http:purge\033[0m: Empties the cache of replies downloaded from the scraping services, which Skyscraper reuses to save requests to them.\n");
       printf("  \033[1;33m--cache ignorenegativecache\033[0m: Switches off the negative functionality (both for queries and updates). This is the default for offline scrapers.\n");
       printf("  \033[1;33m--cache merge:<PATH>\033[0m: Merges two resource caches together. It will merge the resource cache specified by <PATH> into the local resource cache by default. To merge into a non-default destination cache folder set it with '-d <PATH>'. Both should point to folders with the 'db.xml' inside.\n");
       printf("  \033[1;33m--cache purge:all\033[0m: Removes ALL cached resources for the selected platform.\n");
@@ -1989,8 +2112,13 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
       printf("  \033[1;33m--cache validate\033[0m: Checks the consistency of the cache for the selected platform.\n");
       printf("\n");
       removeLockAndExit(0);
-    } else if(!(config.cacheOptions == "edit" ||
+    } else if(!(config.cacheOptions == "compact" ||
+                config.cacheOptions == "convert:xml" ||
+                config.cacheOptions == "convert:binary" ||
+                config.cacheOptions == "convert:sqlite" ||
+                config.cacheOptions == "edit" ||
                 config.cacheOptions.startsWith("edit:") ||
+                config.cacheOptions == "http:purge" ||
                 config.cacheOptions.startsWith("merge:") ||
                 config.cacheOptions.startsWith("purge:") ||
                 config.cacheOptions.startsWith("report:") ||
@@ -2313,27 +2441,40 @@ void Skyscraper::doPrescrapeJobs()
     }
   }
 
-  if(config.scraper == "arcadedb" && config.threads != 1) {
-    printf("\033[1;33mForcing 1 thread to accomodate limits in the ArcadeDB API\033[0m\n\n");
-    config.threads = 1; // Don't change! This limit was set by request from ArcadeDB
-  } else if(config.scraper == "openretro" && config.threads != 1) {
-    printf("\033[1;33mForcing 1 thread to accomodate limits in the OpenRetro API\033[0m\n\n");
-    config.threads = 1; // Don't change! This limit was set by request from OpenRetro
+  // The service limits are host limits shared by all threads (see ScraperWorker::run), so they
+  // hold however many threads are set. These are only defaults, the user settings win
+  const bool limitsSet = (config.requestRate > 0.0 || config.requestsInFlight > 0);
+  if(config.scraper == "arcadedb" && !limitsSet) {
+    printf("\033[1;33mLimiting to 1 request at a time to accomodate limits in the ArcadeDB API\033[0m\n\n");
+    config.requestsInFlight = 1; // Don't change! This limit was set by request from ArcadeDB
+  } else if(config.scraper == "openretro" && !limitsSet) {
+    printf("\033[1;33mLimiting to 1 request at a time to accomodate limits in the OpenRetro API\033[0m\n\n");
+    // Don't change! This limit was set by request from OpenRetro, which also seems to get
+    // tired after a few minutes of high-speed scraping, hence half a second between requests
+    config.requestsInFlight = 1;
+    config.requestRate = 2.0;
+    config.requestBurst = 1;
   } else if(config.scraper == "giantbomb") {
-    if(config.threads != 1 && !config.cacheGb) {
-      printf("\033[1;33mForcing 1 thread to accomodate limits in the GiantBomb API\033[0m\n\n");
-      config.threads = 1; // Don't change! This limit was set by request from GiantBomb
+    if(!config.cacheGb && !limitsSet) {
+      printf("\033[1;33mLimiting to 1 request at a time to accomodate limits in the GiantBomb API\033[0m\n\n");
+      config.requestsInFlight = 1; // Don't change! This limit was set by request from GiantBomb
     }
     if(config.user.isEmpty() || config.password.isEmpty() || config.apiKey.isEmpty()) {
       printf("The GiantBomb scraping module requires user credentials and an API token to "
              "work. Get one here: 'https://www.giantbomb.com/api/'\n");
       removeLockAndExit(1);
     }
+  } else if(config.scraper == "launchbox" && !limitsSet) {
+    // A tenth of a second between requests to the LaunchBox image server
+    config.requestRate = 10.0;
+    config.requestBurst = 10;
   } else if(config.scraper == "igdb") {
-    if(config.threads > 4) {
-      printf("\033[1;33mAdjusting to 4 threads to accomodate limits in the IGDB API\033[0m\n\n");
-      printf("\033[1;32mThis module is powered by IGDB.com\033[0m\n");
-      config.threads = 4; // Don't change! This limit was set by request from IGDB
+    printf("\033[1;32mThis module is powered by IGDB.com\033[0m\n");
+    if(!limitsSet) {
+      // Don't change! The documented IGDB limits: 4 requests per second and 8 open requests
+      config.requestRate = 4.0;
+      config.requestBurst = 4;
+      config.requestsInFlight = 8;
     }
     if(config.user.isEmpty() || config.password.isEmpty()) {
       printf("The IGDB scraping module requires free user credentials to work. Read more about that here: "
@@ -2399,15 +2540,16 @@ void Skyscraper::doPrescrapeJobs()
       printf("\033[1;33mThe Screenscraper service requires an API key, which is missing in "
              "the third field of userCreds. Please complete it.\033[0m\n");
     }
+    // The threads ScreenScraper allows, kept as the open requests to it
+    int allowedThreads = 1; // Don't change! This limit was set by request from ScreenScraper
     if(config.user.isEmpty() || config.password.isEmpty()) {
       if(config.threads > 1) {
-        printf("\033[1;33mForcing 1 threads as this is the anonymous limit in the ScreenScraper "
-               "scraping module. Sign up for an account at https://www.screenscraper.fr and support "
-               "them to gain more threads. Then use the credentials with Skyscraper using the "
+        printf("\033[1;33mLimiting to 1 request at a time as this is the anonymous limit in the "
+               "ScreenScraper scraping module. Sign up for an account at https://www.screenscraper.fr "
+               "and support them to gain more threads. Then use the credentials with Skyscraper using the "
                "'-u user:password' command line option or by setting 'userCreds=\"user:password\"' "
                "in '%s/config.ini'.\033[0m\n\n",
                QDir::currentPath().toStdString().c_str());
-        config.threads = 1; // Don't change! This limit was set by request from ScreenScraper
       }
     } else {
       printf("Fetching limits for user '\033[1;33m%s\033[0m', just a sec...\n", config.user.toStdString().c_str());
@@ -2422,20 +2564,21 @@ void Skyscraper::doPrescrapeJobs()
                  "your credentials correctly in '%s/config.ini'. It needs to "
                  "look EXACTLY like this, but with your USER and PASS:\033[0m\n\033[1;33m"
                  "[screenscraper]\nuserCreds=\"USER:PASS\"\033[0m\033[0;31m\n"
-                 "Continuing with unregistered user, forcing 1 thread...\033[0m\n\n",
+                 "Continuing with unregistered user, 1 request at a time...\033[0m\n\n",
                  QDir::currentPath().toStdString().c_str());
         } else {
           printf("\033[1;33mReceived invalid / empty ScreenScraper server response, maybe "
-                 "their server is busy / overloaded. Forcing 1 thread...\033[0m\n\n");
+                 "their server is busy / overloaded. Continuing with 1 request at a time...\033[0m\n\n");
         }
-        config.threads = 1; // Don't change! This limit was set by request from ScreenScraper
       } else {
-        int allowedThreads = jsonObj["response"].toObject()["ssuser"].toObject()["maxthreads"].toString().toInt();
-        if(allowedThreads != 0) {
-          if(config.threadsSet && config.threads <= allowedThreads) {
-            printf("User is allowed %d threads, but user has set it manually, so ignoring.\n\n", allowedThreads);
+        int userThreads = jsonObj["response"].toObject()["ssuser"].toObject()["maxthreads"].toString().toInt();
+        if(userThreads != 0) {
+          allowedThreads = (userThreads <= 8?userThreads:8);
+          if(config.threadsSet) {
+            printf("User is allowed %d threads, but user has set it manually, so only the open "
+                   "requests are kept to it.\n\n", userThreads);
           } else {
-            config.threads = (allowedThreads <= 8?allowedThreads:8);
+            config.threads = allowedThreads;
             printf("Setting threads to \033[1;32m%d\033[0m as allowed for the supplied user credentials.\n\n", config.threads);
           }
         }
@@ -2449,6 +2592,14 @@ void Skyscraper::doPrescrapeJobs()
         }
       }
     }
+    if(!limitsSet) {
+      // The media of a game are downloaded at the same time, this keeps the connections within
+      // the threads ScreenScraper allows. The requests are 1.2 seconds apart per allowed thread,
+      // a bit above 1.0 as requested by the folks at ScreenScraper. Don't change!
+      config.requestsInFlight = allowedThreads;
+      config.requestRate = allowedThreads / 1.2;
+      config.requestBurst = allowedThreads;
+    }
   }
 }
 
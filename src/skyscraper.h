@@ -88,6 +88,7 @@ private:
   AbstractFrontend *frontend = nullptr;
 
   QSharedPointer<Cache> cache;
+  QSharedPointer<ScraperStages> stages;
 
   QList<GameEntry> gameEntries;
   QStringList cliFiles;
@@ -79,9 +79,10 @@ TheGamesDb::TheGamesDb(Settings *config,
 void TheGamesDb::getSearchResults(QList<GameEntry> &gameEntries,
                                   QString searchName, QString)
 {
-  netComm->request(searchUrlPre + config->userCreds + "&name=" +
-                   NameTools::moveArticle(searchName, true) +
-                   searchUrlPost + platformId);
+  // The reply also reports the allowance left this month, so it must always be fresh
+  netComm->requestUncached(searchUrlPre + config->userCreds + "&name=" +
+                           NameTools::moveArticle(searchName, true) +
+                           searchUrlPost + platformId);
   q.exec();
   if(netComm->getError() == QNetworkReply::NoError) {
     searchError = false;
@@ -361,6 +362,32 @@ void TheGamesDb::getVideo(GameEntry &game)
   }
 }
 
+// The first url each media getter above tries, for the first of the game's ids. The
+// other ids and the png and folder fallbacks are still requested one by one.
+QStringList TheGamesDb::getMediaUrls(GameEntry &game, const QList<int> &types)
+{
+  QStringList urls;
+  const QStringList ids = nameIds.values(game.title);
+  if(ids.isEmpty()) {
+    return urls;
+  }
+  const QString imagesUrl = "https://cdn.thegamesdb.net/images/original/";
+  for(const auto type: std::as_const(types)) {
+    if(type == COVER) {
+      urls.append(imagesUrl + "boxart/front/" + ids.first() + "-1.jpg");
+    } else if(type == SCREENSHOT) {
+      urls.append(imagesUrl + "screenshots/" + ids.first() + "-1.jpg");
+    } else if(type == WHEEL) {
+      urls.append(imagesUrl + "titlescreen/" + ids.first() + "-1.jpg");
+    } else if(type == MARQUEE) {
+      urls.append(imagesUrl + "fanart/" + ids.first() + "-1.jpg");
+    } else if(type == TEXTURE) {
+      urls.append(imagesUrl + "boxart/back/" + ids.first() + "-1.jpg");
+    }
+  }
+  return urls;
+}
+
 void TheGamesDb::loadMaps()
 {
   loadConfig("thegamesdb.json", "code", "id");
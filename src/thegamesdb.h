@@ -59,6 +59,7 @@ protected:
   void getMarquee(GameEntry &game) override;
   void getTexture(GameEntry &game) override;
   void getVideo(GameEntry &game) override;
+  QStringList getMediaUrls(GameEntry &game, const QList<int> &types) override;
 
 private:
   void loadMaps();
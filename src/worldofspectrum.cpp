@@ -366,23 +366,20 @@ void WorldOfSpectrum::getManual(GameEntry &game)
 {
   QString url = resources["manual"];
   if(!url.isEmpty()) {
-    if(url.indexOf("http") != -1) {
-      netComm->request(url);
-    } else {
-      netComm->request(baseUrl + (url.left(1) == "/"?"":"/") + url);
+    if(url.indexOf("http") == -1) {
+      url = baseUrl + (url.left(1) == "/"?"":"/") + url;
     }
-    q.exec();
-    game.manualData = netComm->getData();
+    const qint64 manualSize = getMediaData(url, game.manualData, game.manualFile);
     QByteArray contentType = netComm->getContentType();
     if(netComm->getError() == QNetworkReply::NoError &&
-       !contentType.isEmpty() && game.manualData.size() > 4096) {
+       !contentType.isEmpty() && manualSize > 4096) {
       game.manualFormat = contentType.mid(contentType.indexOf("/") + 1,
                                           contentType.length() - contentType.indexOf("/") + 1);
       if(game.manualFormat.length()>4) {
         game.manualFormat = "pdf";
       }
     } else {
-        game.manualData = "";
+        discardMediaData(game.manualData, game.manualFile);
     }
   }
 }
@@ -391,20 +388,17 @@ void WorldOfSpectrum::getVideo(GameEntry &game)
 {
   QString url = resources["video"];
   if(!url.isEmpty()) {
-    if(url.indexOf("http") != -1) {
-      netComm->request(url);
-    } else {
-      netComm->request(baseUrl + (url.left(1) == "/"?"":"/") + url);
+    if(url.indexOf("http") == -1) {
+      url = baseUrl + (url.left(1) == "/"?"":"/") + url;
     }
-    q.exec();
-    game.videoData = netComm->getData();
+    const qint64 videoSize = getMediaData(url, game.videoData, game.videoFile);
     QByteArray contentType = netComm->getContentType();
     if(netComm->getError() == QNetworkReply::NoError &&
-       !contentType.contains("video/") && game.videoData.size() > 4096) {
+       !contentType.contains("video/") && videoSize > 4096) {
       game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
                                          contentType.length() - contentType.indexOf("/") + 1);
     } else {
-      game.videoData = "";
+      discardMediaData(game.videoData, game.videoFile);
     }
   }
 }